@@ -25,6 +25,7 @@ set(CMAKE_FIND_PACKAGE_NO_SYSTEM_PACKAGE_REGISTRY ON CACHE BOOL
 ### Packages and versions ###
 
 find_package(json 3.10.1 REQUIRED)
+find_package(Threads REQUIRED)
 
 if(CVALUATE_BUILD_TEST)
     # googletest
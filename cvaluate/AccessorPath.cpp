@@ -0,0 +1,60 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <cvaluate/AccessorPath.h>
+#include <cvaluate/Exception.h>
+
+namespace Cvaluate {
+    static const TokenAvaiableData kNullValue;
+
+    AccessorPath::AccessorPath(const TokenAvaiableData& names) {
+        if (names.empty()) {
+            throw CvaluateException("Cant' find varibale name in given strings");
+        }
+
+        this->root_ = names[0].get<std::string>();
+
+        for (size_t i = 1; i < names.size(); i++) {
+            this->fields_.push_back(names[i].get<std::string>());
+        }
+    }
+
+    const std::string& AccessorPath::Root() const {
+        return this->root_;
+    }
+
+    const TokenAvaiableData& AccessorPath::Resolve(const TokenAvaiableData& root) const {
+        const TokenAvaiableData* value = &root;
+
+        for (auto& field: this->fields_) {
+            if (value->is_null()) {
+                return kNullValue;
+            }
+
+            if (!value->is_object()) {
+                throw CvaluateException("Unable to access field '" + field + "' of a non-object value");
+            }
+
+            auto child = value->find(field);
+            if (child == value->end()) {
+                return kNullValue;
+            }
+
+            value = &*child;
+        }
+
+        return *value;
+    }
+} // Cvaluate
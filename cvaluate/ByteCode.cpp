@@ -0,0 +1,358 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <cvaluate/ByteCode.h>
+#include <cvaluate/Exception.h>
+#include <cvaluate/ValueOperators.h>
+
+namespace Cvaluate {
+    struct ProgramBuilder {
+        ByteCodeProgram program;
+        size_t stack_depth = 0;
+        std::unordered_map<std::string, uint32_t> slots;
+
+        uint32_t Slot(const std::string& name) {
+            auto slot = slots.find(name);
+            if (slot != slots.end()) {
+                return slot->second;
+            }
+
+            return slots[name] = Add(program.slots, name);
+        }
+
+        void Emit(OpCode code, uint32_t operand, int stack_effect) {
+            program.instructions.push_back({code, operand});
+            stack_depth += stack_effect;
+            program.max_stack_depth = std::max(program.max_stack_depth, stack_depth);
+        }
+
+        template <typename T>
+        uint32_t Add(std::vector<T>& table, const T& value) {
+            table.push_back(value);
+            return table.size() - 1;
+        }
+    };
+
+    static void CompileStage(ProgramBuilder& builder, std::shared_ptr<EvaluationStage>& stage);
+
+    static void CompileOperand(ProgramBuilder& builder, std::shared_ptr<EvaluationStage>& stage) {
+        if (stage == nullptr) {
+            builder.Emit(OpCode::PUSH_NULL, 0, 1);
+        } else {
+            CompileStage(builder, stage);
+        }
+    }
+
+    static bool FindBinaryOpCode(OperatorSymbol symbol, OpCode& code) {
+        switch (symbol) {
+            case OperatorSymbol::PLUS: code = OpCode::ADD; return true;
+            case OperatorSymbol::MINUS: code = OpCode::SUBTRACT; return true;
+            case OperatorSymbol::MULTIPLY: code = OpCode::MULTIPLY; return true;
+            case OperatorSymbol::DIVIDE: code = OpCode::DIVIDE; return true;
+            case OperatorSymbol::EXPONENT: code = OpCode::EXPONENT; return true;
+            case OperatorSymbol::MODULUS: code = OpCode::MODULUS; return true;
+            case OperatorSymbol::GTE: code = OpCode::GTE; return true;
+            case OperatorSymbol::GT: code = OpCode::GT; return true;
+            case OperatorSymbol::LTE: code = OpCode::LTE; return true;
+            case OperatorSymbol::LT: code = OpCode::LT; return true;
+            case OperatorSymbol::EQ: code = OpCode::EQ; return true;
+            case OperatorSymbol::NEQ: code = OpCode::NEQ; return true;
+            case OperatorSymbol::AND: code = OpCode::AND; return true;
+            case OperatorSymbol::OR: code = OpCode::OR; return true;
+            case OperatorSymbol::TERNARY_TRUE: code = OpCode::TERNARY_IF; return true;
+            case OperatorSymbol::TERNARY_FALSE: code = OpCode::TERNARY_ELSE; return true;
+            case OperatorSymbol::COALESCE: code = OpCode::TERNARY_ELSE; return true;
+            case OperatorSymbol::SEPARATE: code = OpCode::SEPARATE; return true;
+            default: return false;
+        }
+    }
+
+    static OpCode FindShortCircuitOpCode(OperatorSymbol symbol) {
+        switch (symbol) {
+            case OperatorSymbol::AND: return OpCode::JUMP_IF_FALSE;
+            case OperatorSymbol::OR: return OpCode::JUMP_IF_TRUE;
+            case OperatorSymbol::TERNARY_TRUE: return OpCode::JUMP_NULL_IF_FALSE;
+            default: return OpCode::JUMP_IF_NOT_NULL;
+        }
+    }
+
+    static void CompileOperator(ProgramBuilder& builder, std::shared_ptr<EvaluationStage>& stage) {
+        auto& program = builder.program;
+        OpCode code;
+
+        switch (stage->symbol_) {
+            case OperatorSymbol::LITERAL:
+                builder.Emit(OpCode::PUSH_CONSTANT, builder.Add(program.constants, stage->value_), 1);
+                return;
+            case OperatorSymbol::VALUE:
+                builder.Emit(OpCode::LOAD_PARAMETER, builder.Slot(stage->value_.get<std::string>()), 1);
+                return;
+            case OperatorSymbol::ACCESS: {
+                AccessorPath path(stage->value_);
+                builder.Add(program.accessor_slots, builder.Slot(path.Root()));
+                builder.Emit(OpCode::LOAD_ACCESSOR, builder.Add(program.accessors, path), 1);
+                return;
+            }
+            case OperatorSymbol::NOOP:
+                CompileOperand(builder, stage->right_stage_);
+                return;
+            case OperatorSymbol::FUNCTIONAL: {
+                auto arguments = FindArgumentStages(stage->right_stage_);
+                for (auto& argument: arguments) {
+                    CompileOperand(builder, argument);
+                }
+
+                FunctionCall call{stage->variadic_function_, static_cast<uint32_t>(arguments.size())};
+                builder.Emit(OpCode::CALL_FUNCTION, builder.Add(program.functions, call), 1 - static_cast<int>(arguments.size()));
+                return;
+            }
+            case OperatorSymbol::NEGATE:
+                CompileOperand(builder, stage->right_stage_);
+                builder.Emit(OpCode::NEGATE, 0, 0);
+                return;
+            case OperatorSymbol::INVERT:
+                CompileOperand(builder, stage->right_stage_);
+                builder.Emit(OpCode::INVERT, 0, 0);
+                return;
+            default:
+                break;
+        }
+
+        size_t jump = 0;
+
+        CompileOperand(builder, stage->left_stage_);
+
+        if (stage->IsShortCircuitable()) {
+            jump = program.instructions.size();
+            builder.Emit(FindShortCircuitOpCode(stage->symbol_), 0, 0);
+        }
+
+        CompileOperand(builder, stage->right_stage_);
+
+        if (FindBinaryOpCode(stage->symbol_, code)) {
+            builder.Emit(code, 0, -1);
+        } else {
+            builder.Emit(OpCode::CALL_OPERATOR, builder.Add(program.operators, stage->operator_), -1);
+        }
+
+        if (stage->IsShortCircuitable()) {
+            program.instructions[jump].operand = program.instructions.size();
+        }
+    }
+
+    static void CompileStage(ProgramBuilder& builder, std::shared_ptr<EvaluationStage>& stage) {
+        if (stage->shared_index_ < 0) {
+            CompileOperator(builder, stage);
+            return;
+        }
+
+        auto& program = builder.program;
+        uint32_t index = stage->shared_index_;
+        program.shared_count = std::max<size_t>(program.shared_count, index + 1);
+
+        auto load = builder.Add(program.shared_loads, SharedLoad{index, 0});
+        builder.Emit(OpCode::LOAD_SHARED, load, 0);
+        CompileOperator(builder, stage);
+        builder.Emit(OpCode::STORE_SHARED, index, 0);
+        program.shared_loads[load].end = program.instructions.size();
+    }
+
+    /*
+        Flattens a planned stage tree into a program for the `VirtualMachine`.
+        Operands are emitted before their operator, so the program is a post-order walk of the tree.
+    */
+    ByteCodeProgram CompileStages(std::shared_ptr<EvaluationStage> root_stage) {
+        if (root_stage == nullptr) {
+            throw CvaluateException("Found empty stage.");
+        }
+
+        ProgramBuilder builder;
+        CompileStage(builder, root_stage);
+
+        return builder.program;
+    }
+
+    /*
+        Binds the value of every slot name found in [parameters], leaving the others unbound.
+    */
+    ParameterFrame BindParameters(const std::vector<std::string>& slots, const Parameters& parameters) {
+        ParameterFrame frame(slots.size());
+        BindParameters(frame, slots, parameters);
+
+        return frame;
+    }
+
+    /*
+        Rebinds every slot of an existing [frame], so a frame can be reused across parameter sets.
+    */
+    void BindParameters(ParameterFrame& frame, const std::vector<std::string>& slots, const Parameters& parameters) {
+        for (size_t slot = 0; slot < slots.size(); slot++) {
+            auto parameter = parameters.find(slots[slot]);
+            if (parameter != parameters.end()) {
+                frame.Bind(slot, parameter->second);
+            } else {
+                frame.Unbind(slot);
+            }
+        }
+    }
+
+    TokenAvaiableData VirtualMachine::Execute(const ByteCodeProgram& program, const Parameters& parameters) {
+        return this->Execute(program, BindParameters(program.slots, parameters));
+    }
+
+    static Value CallOperator(const EvaluationOperator& stage_operator, const Value& left, const Value& right, ValueArena& arena) {
+        return arena.Store(stage_operator(left.ToJson(), right.ToJson(), kEmptyParameters));
+    }
+
+    TokenAvaiableData VirtualMachine::Execute(const ByteCodeProgram& program, const ParameterFrame& frame) {
+        return this->Run(program, frame).ToJson();
+    }
+
+    bool VirtualMachine::ExecuteBool(const ByteCodeProgram& program, const ParameterFrame& frame) {
+        return this->Run(program, frame).GetBool();
+    }
+
+    /*
+        Executes [program] and returns its result, which stays valid until the next execution.
+    */
+    const Value& VirtualMachine::Run(const ByteCodeProgram& program, const ParameterFrame& frame) {
+        if (frame.Size() < program.slots.size()) {
+            throw CvaluateException("Parameter frame is smaller than the slot table");
+        }
+
+        auto& stack = this->stack_;
+        stack.clear();
+        stack.reserve(program.max_stack_depth);
+        this->shared_.assign(program.shared_count, std::nullopt);
+        this->arena_.Reset();
+
+        auto& instructions = program.instructions;
+
+        for (size_t index = 0; index < instructions.size(); index++) {
+            auto& instruction = instructions[index];
+
+            switch (instruction.code) {
+                case OpCode::PUSH_CONSTANT:
+                    stack.push_back(Value::Borrow(program.constants[instruction.operand]));
+                    continue;
+                case OpCode::PUSH_NULL:
+                    stack.emplace_back();
+                    continue;
+                case OpCode::LOAD_PARAMETER: {
+                    auto parameter = frame.Get(instruction.operand);
+                    if (parameter == nullptr) {
+                        throw CvaluateException("Cant' find varibale name in parameter");
+                    }
+                    stack.push_back(Value::Borrow(*parameter));
+                    continue;
+                }
+                case OpCode::LOAD_ACCESSOR: {
+                    auto parameter = frame.Get(program.accessor_slots[instruction.operand]);
+                    if (parameter == nullptr) {
+                        throw CvaluateException("Cant' find varibale name in parameters");
+                    }
+                    stack.push_back(Value::Borrow(program.accessors[instruction.operand].Resolve(*parameter)));
+                    continue;
+                }
+                case OpCode::LOAD_SHARED: {
+                    auto& load = program.shared_loads[instruction.operand];
+                    auto& result = this->shared_[load.index];
+                    if (result) {
+                        stack.push_back(*result);
+                        index = load.end - 1;
+                    }
+                    continue;
+                }
+                case OpCode::STORE_SHARED:
+                    this->shared_[instruction.operand] = stack.back();
+                    continue;
+                case OpCode::CALL_FUNCTION: {
+                    auto& call = program.functions[instruction.operand];
+                    auto first = stack.size() - call.arguments;
+                    auto result = this->arena_.Store(call.function(this->arena_.Arguments(stack.data() + first, call.arguments)));
+                    stack.resize(first);
+                    stack.push_back(result);
+                    continue;
+                }
+                case OpCode::NEGATE:
+                    stack.back() = NegateOperator::Apply(stack.back());
+                    continue;
+                case OpCode::INVERT:
+                    stack.back() = InvertOperator::Apply(stack.back());
+                    continue;
+                case OpCode::JUMP_IF_FALSE:
+                    if (stack.back().IsBool() && !stack.back().GetBool()) {
+                        index = instruction.operand - 1;
+                    }
+                    continue;
+                case OpCode::JUMP_IF_TRUE:
+                    if (stack.back().IsBool() && stack.back().GetBool()) {
+                        index = instruction.operand - 1;
+                    }
+                    continue;
+                case OpCode::JUMP_IF_NOT_NULL:
+                    if (!stack.back().IsNull()) {
+                        index = instruction.operand - 1;
+                    }
+                    continue;
+                case OpCode::JUMP_NULL_IF_FALSE:
+                    if (stack.back().IsBool() && !stack.back().GetBool()) {
+                        stack.back() = Value();
+                        index = instruction.operand - 1;
+                    }
+                    continue;
+                default:
+                    break;
+            }
+
+            auto right = stack.back();
+            stack.pop_back();
+            auto& left = stack.back();
+
+            switch (instruction.code) {
+                case OpCode::CALL_OPERATOR:
+                    left = CallOperator(program.operators[instruction.operand], left, right, this->arena_);
+                    break;
+                case OpCode::ADD: left = AddOperator::Apply(left, right, this->arena_); break;
+                case OpCode::SUBTRACT: left = SubtractOperator::Apply(left, right, this->arena_); break;
+                case OpCode::MULTIPLY: left = MultiplyOperator::Apply(left, right, this->arena_); break;
+                case OpCode::DIVIDE: left = DivideOperator::Apply(left, right, this->arena_); break;
+                case OpCode::EXPONENT: left = ExponentOperator::Apply(left, right, this->arena_); break;
+                case OpCode::MODULUS: left = ModulusOperator::Apply(left, right, this->arena_); break;
+                case OpCode::GTE: left = GteOperator::Apply(left, right, this->arena_); break;
+                case OpCode::GT: left = GtOperator::Apply(left, right, this->arena_); break;
+                case OpCode::LTE: left = LteOperator::Apply(left, right, this->arena_); break;
+                case OpCode::LT: left = LtOperator::Apply(left, right, this->arena_); break;
+                case OpCode::EQ: left = EqualOperator::Apply(left, right, this->arena_); break;
+                case OpCode::NEQ: left = NotEqualOperator::Apply(left, right, this->arena_); break;
+                case OpCode::AND: left = AndOperator::Apply(left, right, this->arena_); break;
+                case OpCode::OR: left = OrOperator::Apply(left, right, this->arena_); break;
+                case OpCode::TERNARY_IF: left = TernaryIfOperator::Apply(left, right, this->arena_); break;
+                case OpCode::TERNARY_ELSE: left = TernaryElseOperator::Apply(left, right, this->arena_); break;
+                case OpCode::SEPARATE:
+                    left = CallOperator(SeparatorStage, left, right, this->arena_);
+                    break;
+                default:
+                    throw CvaluateException("Unknown instruction");
+            }
+        }
+
+        if (stack.size() != 1) {
+            throw CvaluateException("Broken byte code program");
+        }
+
+        return stack.back();
+    }
+} // Cvaluate
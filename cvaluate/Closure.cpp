@@ -0,0 +1,439 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <cvaluate/Closure.h>
+#include <cvaluate/Exception.h>
+#include <cvaluate/ValueOperators.h>
+
+namespace Cvaluate {
+    struct ClosureContext {
+        const ParameterFrame& frame;
+        ValueArena& arena;
+        std::optional<Value>* shared;
+    };
+
+    class ClosureNode {
+        public:
+            virtual ~ClosureNode() = default;
+            virtual Value Evaluate(ClosureContext& context) const = 0;
+    };
+
+    /*
+        Operands of the nodes. Leaf stages are loaded inline, any other stage is a child node.
+    */
+    struct ConstantOperand {
+        Value value;
+
+        Value Load(ClosureContext&) const {
+            return this->value;
+        }
+    };
+
+    struct ParameterOperand {
+        uint32_t slot;
+
+        Value Load(ClosureContext& context) const {
+            auto parameter = context.frame.Get(this->slot);
+            if (parameter == nullptr) {
+                throw CvaluateException("Cant' find varibale name in parameter");
+            }
+            return Value::Borrow(*parameter);
+        }
+    };
+
+    struct AccessorOperand {
+        uint32_t slot;
+        AccessorPath path;
+
+        Value Load(ClosureContext& context) const {
+            auto parameter = context.frame.Get(this->slot);
+            if (parameter == nullptr) {
+                throw CvaluateException("Cant' find varibale name in parameters");
+            }
+            return Value::Borrow(this->path.Resolve(*parameter));
+        }
+    };
+
+    struct NodeOperand {
+        std::unique_ptr<ClosureNode> node;
+
+        Value Load(ClosureContext& context) const {
+            return this->node->Evaluate(context);
+        }
+    };
+
+    /*
+        How binary nodes combine their operands.
+        Strict operators load both operands, the others skip the right operand when the left one decides the result.
+    */
+    template <typename Operator>
+    struct StrictEvaluation {
+        template <typename Left, typename Right>
+        static Value Evaluate(const Left& left, const Right& right, ClosureContext& context) {
+            auto left_value = left.Load(context);
+            auto right_value = right.Load(context);
+            return Operator::Apply(left_value, right_value, context.arena);
+        }
+    };
+
+    struct AndEvaluation {
+        template <typename Left, typename Right>
+        static Value Evaluate(const Left& left, const Right& right, ClosureContext& context) {
+            auto left_value = left.Load(context);
+            if (left_value.IsBool() && !left_value.GetBool()) {
+                return left_value;
+            }
+            return AndOperator::Apply(left_value, right.Load(context), context.arena);
+        }
+    };
+
+    struct OrEvaluation {
+        template <typename Left, typename Right>
+        static Value Evaluate(const Left& left, const Right& right, ClosureContext& context) {
+            auto left_value = left.Load(context);
+            if (left_value.IsBool() && left_value.GetBool()) {
+                return left_value;
+            }
+            return OrOperator::Apply(left_value, right.Load(context), context.arena);
+        }
+    };
+
+    struct TernaryIfEvaluation {
+        template <typename Left, typename Right>
+        static Value Evaluate(const Left& left, const Right& right, ClosureContext& context) {
+            auto left_value = left.Load(context);
+            if (left_value.IsBool() && !left_value.GetBool()) {
+                return Value();
+            }
+            return TernaryIfOperator::Apply(left_value, right.Load(context), context.arena);
+        }
+    };
+
+    struct TernaryElseEvaluation {
+        template <typename Left, typename Right>
+        static Value Evaluate(const Left& left, const Right& right, ClosureContext& context) {
+            auto left_value = left.Load(context);
+            if (!left_value.IsNull()) {
+                return left_value;
+            }
+            return right.Load(context);
+        }
+    };
+
+    template <typename Operand>
+    class LoadNode : public ClosureNode {
+        private:
+            Operand operand_;
+        public:
+            explicit LoadNode(Operand operand) : operand_(std::move(operand)) {};
+
+            Value Evaluate(ClosureContext& context) const override {
+                return this->operand_.Load(context);
+            }
+    };
+
+    template <typename Operator, typename Operand>
+    class UnaryNode : public ClosureNode {
+        private:
+            Operand operand_;
+        public:
+            explicit UnaryNode(Operand operand) : operand_(std::move(operand)) {};
+
+            Value Evaluate(ClosureContext& context) const override {
+                return Operator::Apply(this->operand_.Load(context));
+            }
+    };
+
+    template <typename Evaluation, typename Left, typename Right>
+    class BinaryNode : public ClosureNode {
+        private:
+            Left left_;
+            Right right_;
+        public:
+            BinaryNode(Left left, Right right) : left_(std::move(left)), right_(std::move(right)) {};
+
+            Value Evaluate(ClosureContext& context) const override {
+                return Evaluation::Evaluate(this->left_, this->right_, context);
+            }
+    };
+
+    // User functions keep their type-erased call, their arguments are passed in the storage of the arena.
+    class FunctionNode : public ClosureNode {
+        private:
+            VariadicFunction function_;
+            std::vector<NodeOperand> arguments_;
+        public:
+            FunctionNode(VariadicFunction function, std::vector<NodeOperand> arguments) :
+                function_(std::move(function)), arguments_(std::move(arguments)) {};
+
+            Value Evaluate(ClosureContext& context) const override {
+                auto count = this->arguments_.size();
+                ArgumentBuffer<Value> values(count);
+
+                for (size_t i = 0; i < count; i++) {
+                    values.Data()[i] = this->arguments_[i].Load(context);
+                }
+
+                return context.arena.Store(this->function_(context.arena.Arguments(values.Data(), count)));
+            }
+    };
+
+    // Operators that only exist for `TokenAvaiableData`, like the separator.
+    class OperatorNode : public ClosureNode {
+        private:
+            EvaluationOperator operator_;
+            NodeOperand left_;
+            NodeOperand right_;
+        public:
+            OperatorNode(EvaluationOperator stage_operator, NodeOperand left, NodeOperand right) :
+                operator_(std::move(stage_operator)), left_(std::move(left)), right_(std::move(right)) {};
+
+            Value Evaluate(ClosureContext& context) const override {
+                auto left = this->left_.Load(context).ToJson();
+                auto right = this->right_.Load(context).ToJson();
+                return context.arena.Store(this->operator_(left, right, kEmptyParameters));
+            }
+    };
+
+    // A stage with several parents, computed by the first parent reaching it and reused by the others.
+    class SharedNode : public ClosureNode {
+        private:
+            uint32_t index_;
+            std::unique_ptr<ClosureNode> node_;
+        public:
+            SharedNode(uint32_t index, std::unique_ptr<ClosureNode> node) : index_(index), node_(std::move(node)) {};
+
+            Value Evaluate(ClosureContext& context) const override {
+                auto& result = context.shared[this->index_];
+                if (!result) {
+                    result = this->node_->Evaluate(context);
+                }
+                return *result;
+            }
+    };
+
+    class ClosureCompiler {
+        private:
+            ClosureProgram& program_;
+            std::unordered_map<std::string, uint32_t> slots_;
+
+            enum class OperandKind {
+                CONSTANT,
+                PARAMETER,
+                ACCESSOR,
+                NODE,
+            };
+
+            static OperandKind FindOperandKind(const std::shared_ptr<EvaluationStage>& stage) {
+                if (stage == nullptr) {
+                    return OperandKind::CONSTANT;
+                }
+
+                switch (stage->symbol_) {
+                    case OperatorSymbol::LITERAL: return OperandKind::CONSTANT;
+                    case OperatorSymbol::VALUE: return OperandKind::PARAMETER;
+                    case OperatorSymbol::ACCESS: return OperandKind::ACCESSOR;
+                    default: return OperandKind::NODE;
+                }
+            }
+
+            uint32_t FindSlot(const std::string& name) const {
+                auto slot = this->slots_.find(name);
+                if (slot == this->slots_.end()) {
+                    throw CvaluateException("Cant' find slot of varibale " + name);
+                }
+                return slot->second;
+            }
+
+            ConstantOperand MakeConstant(const std::shared_ptr<EvaluationStage>& stage) {
+                if (stage == nullptr) {
+                    return ConstantOperand{Value()};
+                }
+
+                this->program_.constants_.push_back(stage->value_);
+                return ConstantOperand{Value::Borrow(this->program_.constants_.back())};
+            }
+
+            ParameterOperand MakeParameter(const std::shared_ptr<EvaluationStage>& stage) {
+                return ParameterOperand{this->FindSlot(stage->value_.get<std::string>())};
+            }
+
+            AccessorOperand MakeAccessor(const std::shared_ptr<EvaluationStage>& stage) {
+                AccessorPath path(stage->value_);
+                return AccessorOperand{this->FindSlot(path.Root()), path};
+            }
+
+            NodeOperand MakeNode(const std::shared_ptr<EvaluationStage>& stage) {
+                return NodeOperand{this->Compile(stage)};
+            }
+
+            template <typename Evaluation, typename Left>
+            std::unique_ptr<ClosureNode> MakeBinaryNode(Left left, const std::shared_ptr<EvaluationStage>& right) {
+                switch (FindOperandKind(right)) {
+                    case OperandKind::CONSTANT:
+                        return std::make_unique<BinaryNode<Evaluation, Left, ConstantOperand>>(std::move(left), this->MakeConstant(right));
+                    case OperandKind::PARAMETER:
+                        return std::make_unique<BinaryNode<Evaluation, Left, ParameterOperand>>(std::move(left), this->MakeParameter(right));
+                    case OperandKind::ACCESSOR:
+                        return std::make_unique<BinaryNode<Evaluation, Left, AccessorOperand>>(std::move(left), this->MakeAccessor(right));
+                    default:
+                        return std::make_unique<BinaryNode<Evaluation, Left, NodeOperand>>(std::move(left), this->MakeNode(right));
+                }
+            }
+
+            template <typename Evaluation>
+            std::unique_ptr<ClosureNode> MakeBinaryNode(const std::shared_ptr<EvaluationStage>& stage) {
+                auto& left = stage->left_stage_;
+
+                switch (FindOperandKind(left)) {
+                    case OperandKind::CONSTANT:
+                        return this->MakeBinaryNode<Evaluation>(this->MakeConstant(left), stage->right_stage_);
+                    case OperandKind::PARAMETER:
+                        return this->MakeBinaryNode<Evaluation>(this->MakeParameter(left), stage->right_stage_);
+                    case OperandKind::ACCESSOR:
+                        return this->MakeBinaryNode<Evaluation>(this->MakeAccessor(left), stage->right_stage_);
+                    default:
+                        return this->MakeBinaryNode<Evaluation>(this->MakeNode(left), stage->right_stage_);
+                }
+            }
+
+            template <typename Operator>
+            std::unique_ptr<ClosureNode> MakeUnaryNode(const std::shared_ptr<EvaluationStage>& stage) {
+                auto& right = stage->right_stage_;
+
+                switch (FindOperandKind(right)) {
+                    case OperandKind::CONSTANT:
+                        return std::make_unique<UnaryNode<Operator, ConstantOperand>>(this->MakeConstant(right));
+                    case OperandKind::PARAMETER:
+                        return std::make_unique<UnaryNode<Operator, ParameterOperand>>(this->MakeParameter(right));
+                    case OperandKind::ACCESSOR:
+                        return std::make_unique<UnaryNode<Operator, AccessorOperand>>(this->MakeAccessor(right));
+                    default:
+                        return std::make_unique<UnaryNode<Operator, NodeOperand>>(this->MakeNode(right));
+                }
+            }
+        public:
+            ClosureCompiler(ClosureProgram& program, const std::vector<std::string>& slots) : program_(program) {
+                for (size_t slot = 0; slot < slots.size(); slot++) {
+                    this->slots_[slots[slot]] = slot;
+                }
+            }
+
+            void CompileRoot(const std::shared_ptr<EvaluationStage>& root_stage) {
+                this->program_.root_ = this->Compile(root_stage);
+                this->program_.slot_count_ = this->slots_.size();
+            }
+
+            std::unique_ptr<ClosureNode> Compile(const std::shared_ptr<EvaluationStage>& stage) {
+                if (stage == nullptr) {
+                    return std::make_unique<LoadNode<ConstantOperand>>(this->MakeConstant(stage));
+                }
+
+                if (stage->shared_index_ < 0) {
+                    return this->CompileOperator(stage);
+                }
+
+                uint32_t index = stage->shared_index_;
+                this->program_.shared_count_ = std::max<size_t>(this->program_.shared_count_, index + 1);
+
+                return std::make_unique<SharedNode>(index, this->CompileOperator(stage));
+            }
+
+            std::unique_ptr<ClosureNode> CompileOperator(const std::shared_ptr<EvaluationStage>& stage) {
+                switch (stage->symbol_) {
+                    case OperatorSymbol::LITERAL:
+                        return std::make_unique<LoadNode<ConstantOperand>>(this->MakeConstant(stage));
+                    case OperatorSymbol::VALUE:
+                        return std::make_unique<LoadNode<ParameterOperand>>(this->MakeParameter(stage));
+                    case OperatorSymbol::ACCESS:
+                        return std::make_unique<LoadNode<AccessorOperand>>(this->MakeAccessor(stage));
+                    case OperatorSymbol::NOOP:
+                        return this->Compile(stage->right_stage_);
+                    case OperatorSymbol::FUNCTIONAL: {
+                        std::vector<NodeOperand> arguments;
+                        for (auto& argument: FindArgumentStages(stage->right_stage_)) {
+                            arguments.push_back(this->MakeNode(argument));
+                        }
+                        return std::make_unique<FunctionNode>(stage->variadic_function_, std::move(arguments));
+                    }
+                    case OperatorSymbol::NEGATE: return this->MakeUnaryNode<NegateOperator>(stage);
+                    case OperatorSymbol::INVERT: return this->MakeUnaryNode<InvertOperator>(stage);
+                    case OperatorSymbol::PLUS: return this->MakeBinaryNode<StrictEvaluation<AddOperator>>(stage);
+                    case OperatorSymbol::MINUS: return this->MakeBinaryNode<StrictEvaluation<SubtractOperator>>(stage);
+                    case OperatorSymbol::MULTIPLY: return this->MakeBinaryNode<StrictEvaluation<MultiplyOperator>>(stage);
+                    case OperatorSymbol::DIVIDE: return this->MakeBinaryNode<StrictEvaluation<DivideOperator>>(stage);
+                    case OperatorSymbol::EXPONENT: return this->MakeBinaryNode<StrictEvaluation<ExponentOperator>>(stage);
+                    case OperatorSymbol::MODULUS: return this->MakeBinaryNode<StrictEvaluation<ModulusOperator>>(stage);
+                    case OperatorSymbol::GTE: return this->MakeBinaryNode<StrictEvaluation<GteOperator>>(stage);
+                    case OperatorSymbol::GT: return this->MakeBinaryNode<StrictEvaluation<GtOperator>>(stage);
+                    case OperatorSymbol::LTE: return this->MakeBinaryNode<StrictEvaluation<LteOperator>>(stage);
+                    case OperatorSymbol::LT: return this->MakeBinaryNode<StrictEvaluation<LtOperator>>(stage);
+                    case OperatorSymbol::EQ: return this->MakeBinaryNode<StrictEvaluation<EqualOperator>>(stage);
+                    case OperatorSymbol::NEQ: return this->MakeBinaryNode<StrictEvaluation<NotEqualOperator>>(stage);
+                    case OperatorSymbol::AND: return this->MakeBinaryNode<AndEvaluation>(stage);
+                    case OperatorSymbol::OR: return this->MakeBinaryNode<OrEvaluation>(stage);
+                    case OperatorSymbol::TERNARY_TRUE: return this->MakeBinaryNode<TernaryIfEvaluation>(stage);
+                    case OperatorSymbol::TERNARY_FALSE:
+                    case OperatorSymbol::COALESCE:
+                        return this->MakeBinaryNode<TernaryElseEvaluation>(stage);
+                    default:
+                        return std::make_unique<OperatorNode>(stage->operator_,
+                            this->MakeNode(stage->left_stage_), this->MakeNode(stage->right_stage_));
+                }
+            }
+    };
+
+    ClosureProgram::ClosureProgram() = default;
+
+    ClosureProgram::~ClosureProgram() = default;
+
+    TokenAvaiableData ClosureProgram::Execute(const ParameterFrame& frame) const {
+        ValueArena arena;
+        return this->Run(frame, arena).ToJson();
+    }
+
+    TokenAvaiableData ClosureProgram::Execute(const ParameterFrame& frame, ValueArena& arena) const {
+        return this->Run(frame, arena).ToJson();
+    }
+
+    bool ClosureProgram::ExecuteBool(const ParameterFrame& frame, ValueArena& arena) const {
+        return this->Run(frame, arena).GetBool();
+    }
+
+    Value ClosureProgram::Run(const ParameterFrame& frame, ValueArena& arena) const {
+        if (frame.Size() < this->slot_count_) {
+            throw CvaluateException("Parameter frame is smaller than the slot table");
+        }
+
+        arena.Reset();
+        std::vector<std::optional<Value>> shared(this->shared_count_);
+        ClosureContext context{frame, arena, shared.data()};
+
+        return this->root_->Evaluate(context);
+    }
+
+    std::shared_ptr<ClosureProgram> CompileClosures(const std::shared_ptr<EvaluationStage>& root_stage,
+            const std::vector<std::string>& slots) {
+        if (root_stage == nullptr) {
+            throw CvaluateException("Found empty stage.");
+        }
+
+        auto program = std::make_shared<ClosureProgram>();
+        ClosureCompiler compiler(*program, slots);
+        compiler.CompileRoot(root_stage);
+
+        return program;
+    }
+} // Cvaluate
@@ -0,0 +1,758 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <cvaluate/Columnar.h>
+#include <cvaluate/Exception.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CVALUATE_COLUMN_DISPATCH 1
+#else
+#define CVALUATE_COLUMN_DISPATCH 0
+#endif
+
+namespace Cvaluate {
+    Bitmap::Bitmap(size_t size, bool value) : words_((size + 63) / 64, value ? ~uint64_t(0) : 0), size_(size) {
+        // keep the bits past the end clear, so they aren't counted.
+        if (value && size % 64 != 0) {
+            this->words_.back() = (uint64_t(1) << (size % 64)) - 1;
+        }
+    }
+
+    void Bitmap::Set(size_t index, bool value) {
+        auto bit = uint64_t(1) << (index % 64);
+
+        if (value) {
+            this->words_[index / 64] |= bit;
+        } else {
+            this->words_[index / 64] &= ~bit;
+        }
+    }
+
+    size_t Bitmap::Count() const {
+        size_t count = 0;
+
+        for (auto word: this->words_) {
+            count += __builtin_popcountll(word);
+        }
+
+        return count;
+    }
+
+    Column::Column(ColumnType type, size_t size, Bitmap nulls) : type_(type), size_(size), nulls_(std::move(nulls)) {
+        if (!this->nulls_.Empty() && this->nulls_.Size() != size) {
+            throw CvaluateException("Null bitmap size doesn't match the column size");
+        }
+    }
+
+    Column Column::Numeric(std::vector<float> values, Bitmap nulls) {
+        Column ret(ColumnType::NUMERIC, values.size(), std::move(nulls));
+        ret.numbers_ = std::move(values);
+        return ret;
+    }
+
+    Column Column::Boolean(std::vector<uint8_t> values, Bitmap nulls) {
+        Column ret(ColumnType::BOOLEAN, values.size(), std::move(nulls));
+        ret.booleans_ = std::move(values);
+        return ret;
+    }
+
+    Column Column::String(std::vector<std::string> values, Bitmap nulls) {
+        Column ret(ColumnType::STRING, values.size(), std::move(nulls));
+        ret.strings_ = std::move(values);
+        return ret;
+    }
+
+    TokenAvaiableData Column::Get(size_t row) const {
+        if (this->IsNull(row)) {
+            return nullptr;
+        }
+
+        switch (this->type_) {
+            case ColumnType::NUMERIC: return this->numbers_[row];
+            case ColumnType::BOOLEAN: return this->booleans_[row] != 0;
+            default: return this->strings_[row];
+        }
+    }
+
+    Bitmap Column::Matches() const {
+        if (this->type_ != ColumnType::BOOLEAN) {
+            throw CvaluateException("Can't get bool from current token");
+        }
+
+        Bitmap ret(this->size_);
+
+        for (size_t row = 0; row < this->size_; row++) {
+            if (this->booleans_[row] && !this->IsNull(row)) {
+                ret.Set(row, true);
+            }
+        }
+
+        return ret;
+    }
+
+    void ColumnBatch::Add(const std::string& name, Column column) {
+        if (column.Size() != this->rows_) {
+            throw CvaluateException("Column size doesn't match the batch size");
+        }
+
+        this->columns_.insert_or_assign(name, std::move(column));
+    }
+
+    const Column* ColumnBatch::Find(const std::string& name) const {
+        auto column = this->columns_.find(name);
+
+        if (column == this->columns_.end()) {
+            return nullptr;
+        }
+
+        return &column->second;
+    }
+
+    Parameters ColumnBatch::GetRow(size_t row) const {
+        Parameters ret;
+
+        for (auto& column: this->columns_) {
+            auto& name = column.first;
+            auto separator = name.find('.');
+
+            if (separator == std::string::npos) {
+                ret[name] = column.second.Get(row);
+                continue;
+            }
+
+            auto* value = &ret[name.substr(0, separator)];
+            while (separator != std::string::npos) {
+                auto next = name.find('.', separator + 1);
+                value = &(*value)[name.substr(separator + 1, next - separator - 1)];
+                separator = next;
+            }
+            *value = column.second.Get(row);
+        }
+
+        return ret;
+    }
+
+    SimdLevel DetectSimdLevel() {
+        static const SimdLevel level = [] {
+#if CVALUATE_COLUMN_DISPATCH
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+                return SimdLevel::AVX512;
+            }
+            if (__builtin_cpu_supports("avx2")) {
+                return SimdLevel::AVX2;
+            }
+            if (__builtin_cpu_supports("sse4.2")) {
+                return SimdLevel::SSE4_2;
+            }
+#endif
+            return SimdLevel::SCALAR;
+        }();
+
+        return level;
+    }
+
+    /*
+        Kernel loops. They're plain loops left to the compiler's vectorizer,
+        `Dispatch` instantiates each of them once per instruction set and picks one at runtime.
+        Scalar operands, like literals, are read at index 0.
+    */
+    template <typename Loop>
+    struct Dispatch {
+        template <typename... Args>
+        static void Scalar(Args... args) {
+            Loop::Run(args...);
+        }
+
+#if CVALUATE_COLUMN_DISPATCH
+        template <typename... Args>
+        __attribute__((target("sse4.2"))) static void Sse42(Args... args) {
+            Loop::Run(args...);
+        }
+
+        template <typename... Args>
+        __attribute__((target("avx2"))) static void Avx2(Args... args) {
+            Loop::Run(args...);
+        }
+
+        template <typename... Args>
+        __attribute__((target("avx512f,avx512bw"))) static void Avx512(Args... args) {
+            Loop::Run(args...);
+        }
+#endif
+
+        template <typename... Args>
+        static void Run(SimdLevel level, Args... args) {
+            switch (level) {
+#if CVALUATE_COLUMN_DISPATCH
+                case SimdLevel::AVX512: return Avx512(args...);
+                case SimdLevel::AVX2: return Avx2(args...);
+                case SimdLevel::SSE4_2: return Sse42(args...);
+#endif
+                default: return Scalar(args...);
+            }
+        }
+    };
+
+    template <typename Operator, bool kLeftScalar, bool kRightScalar>
+    struct NumericLoop {
+        static void Run(const float* left, const float* right, float* out, size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                out[i] = Operator::Apply(left[kLeftScalar ? 0 : i], right[kRightScalar ? 0 : i]);
+            }
+        }
+    };
+
+    template <typename Operator, bool kLeftScalar, bool kRightScalar>
+    struct CompareLoop {
+        static void Run(const float* left, const float* right, uint8_t* out, size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                out[i] = Operator::Apply(left[kLeftScalar ? 0 : i], right[kRightScalar ? 0 : i]);
+            }
+        }
+    };
+
+    struct OrMaskLoop {
+        static void Run(const uint8_t* left, const uint8_t* right, uint8_t* out, size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                out[i] = left[i] | right[i];
+            }
+        }
+    };
+
+    // Nulls are equal to each other and different from any value.
+    struct EqualNullsLoop {
+        static void Run(const uint8_t* equal, const uint8_t* left_nulls, const uint8_t* right_nulls, uint8_t* out, size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                out[i] = (left_nulls[i] & right_nulls[i]) | (equal[i] & !(left_nulls[i] | right_nulls[i]));
+            }
+        }
+    };
+
+    /*
+        Logical operators with the short-circuit of the row evaluation: a deciding left value hides any error on the right.
+        [kDecidingValue] is false for AND and true for OR.
+    */
+    template <bool kDecidingValue>
+    struct LogicalLoop {
+        static void Run(const uint8_t* left, const uint8_t* left_failed, const uint8_t* right, const uint8_t* right_failed,
+                uint8_t* out, uint8_t* failed, size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                uint8_t decided = uint8_t(left_failed[i] == 0) & (left[i] == kDecidingValue);
+                out[i] = kDecidingValue ? (left[i] | right[i]) : (left[i] & right[i]);
+                failed[i] = uint8_t(decided == 0) & (left_failed[i] | right_failed[i]);
+            }
+        }
+    };
+
+    struct AddNumbers { static float Apply(float left, float right) { return left + right; } };
+    struct SubtractNumbers { static float Apply(float left, float right) { return left - right; } };
+    struct MultiplyNumbers { static float Apply(float left, float right) { return left * right; } };
+    struct DivideNumbers { static float Apply(float left, float right) { return left / right; } };
+    struct GteNumbers { static uint8_t Apply(float left, float right) { return left >= right; } };
+    struct GtNumbers { static uint8_t Apply(float left, float right) { return left > right; } };
+    struct LteNumbers { static uint8_t Apply(float left, float right) { return left <= right; } };
+    struct LtNumbers { static uint8_t Apply(float left, float right) { return left < right; } };
+    struct EqualNumbers { static uint8_t Apply(float left, float right) { return left == right; } };
+
+    template <template <typename, bool, bool> class Loop, typename Operator, typename Output>
+    static void RunBinaryLoop(SimdLevel level, const float* left, bool left_scalar, const float* right, bool right_scalar,
+            Output* out, size_t count) {
+        if (left_scalar) {
+            Dispatch<Loop<Operator, true, false>>::Run(level, left, right, out, count);
+        } else if (right_scalar) {
+            Dispatch<Loop<Operator, false, true>>::Run(level, left, right, out, count);
+        } else {
+            Dispatch<Loop<Operator, false, false>>::Run(level, left, right, out, count);
+        }
+    }
+
+    // Thrown when a stage has no kernel, so the whole tree is evaluated row by row.
+    struct UnsupportedColumnStage {};
+
+    /*
+        Intermediate result of a stage over the whole batch.
+        Values are borrowed from the batch or owned, `nulls` marks null values and `failed` marks rows whose evaluation threw.
+    */
+    struct ColumnVector {
+        ColumnType type = ColumnType::NUMERIC;
+        bool scalar = false;
+        const float* numbers = nullptr;
+        const uint8_t* booleans = nullptr;
+        const std::string* strings = nullptr;
+        const uint8_t* nulls = nullptr;
+        const uint8_t* failed = nullptr;
+
+        std::vector<float> owned_numbers;
+        std::vector<uint8_t> owned_booleans;
+        std::vector<std::string> owned_strings;
+        std::vector<uint8_t> owned_nulls;
+        std::vector<uint8_t> owned_failed;
+    };
+
+    class ColumnEvaluator {
+        private:
+            const ColumnBatch& batch_;
+            SimdLevel level_;
+            size_t rows_;
+            // Shared all-clear mask for vectors without nulls or failures.
+            std::vector<uint8_t> zeros_;
+
+            ColumnVector MakeFailed(ColumnType type) {
+                ColumnVector ret;
+                ret.type = type;
+                ret.nulls = this->zeros_.data();
+                ret.owned_failed.assign(this->rows_, 1);
+                ret.failed = ret.owned_failed.data();
+                ret.owned_numbers.assign(this->rows_, 0);
+                ret.numbers = ret.owned_numbers.data();
+                ret.owned_booleans.assign(this->rows_, 0);
+                ret.booleans = ret.owned_booleans.data();
+                return ret;
+            }
+
+            // Rows where either operand is null or failed.
+            std::vector<uint8_t> FailedOperands(const ColumnVector& left, const ColumnVector& right) {
+                std::vector<uint8_t> ret(this->rows_), nulls(this->rows_);
+                Dispatch<OrMaskLoop>::Run(this->level_, left.failed, right.failed, ret.data(), this->rows_);
+                Dispatch<OrMaskLoop>::Run(this->level_, left.nulls, right.nulls, nulls.data(), this->rows_);
+                Dispatch<OrMaskLoop>::Run(this->level_, ret.data(), nulls.data(), ret.data(), this->rows_);
+                return ret;
+            }
+
+            ColumnVector Broadcast(const ColumnVector& vector) {
+                if (!vector.scalar) {
+                    throw CvaluateException("Only scalar vectors can be broadcast");
+                }
+
+                ColumnVector ret;
+                ret.type = vector.type;
+                ret.nulls = vector.nulls;
+                ret.failed = vector.failed;
+
+                switch (vector.type) {
+                    case ColumnType::NUMERIC:
+                        ret.owned_numbers.assign(this->rows_, vector.numbers[0]);
+                        ret.numbers = ret.owned_numbers.data();
+                        break;
+                    case ColumnType::BOOLEAN:
+                        ret.owned_booleans.assign(this->rows_, vector.booleans[0]);
+                        ret.booleans = ret.owned_booleans.data();
+                        break;
+                    default:
+                        ret.owned_strings.assign(this->rows_, vector.strings[0]);
+                        ret.strings = ret.owned_strings.data();
+                        break;
+                }
+
+                return ret;
+            }
+
+            ColumnVector Load(const std::string& name) {
+                auto column = this->batch_.Find(name);
+
+                if (column == nullptr) {
+                    throw CvaluateException("Cant' find column " + name);
+                }
+
+                ColumnVector ret;
+                ret.type = column->Type();
+                ret.numbers = column->Numbers().data();
+                ret.booleans = column->Booleans().data();
+                ret.strings = column->Strings().data();
+                ret.failed = this->zeros_.data();
+
+                if (column->Nulls().Empty()) {
+                    ret.nulls = this->zeros_.data();
+                } else {
+                    ret.owned_nulls.resize(this->rows_);
+                    for (size_t row = 0; row < this->rows_; row++) {
+                        ret.owned_nulls[row] = column->Nulls().Get(row);
+                    }
+                    ret.nulls = ret.owned_nulls.data();
+                }
+
+                return ret;
+            }
+
+            ColumnVector Literal(const TokenAvaiableData& value) {
+                ColumnVector ret;
+                ret.scalar = true;
+                ret.nulls = this->zeros_.data();
+                ret.failed = this->zeros_.data();
+
+                if (value.is_number()) {
+                    ret.type = ColumnType::NUMERIC;
+                    ret.owned_numbers = {GetTokenValueNumeric(value)};
+                    ret.numbers = ret.owned_numbers.data();
+                } else if (value.is_boolean()) {
+                    ret.type = ColumnType::BOOLEAN;
+                    ret.owned_booleans = {value.get<bool>()};
+                    ret.booleans = ret.owned_booleans.data();
+                } else if (value.is_string()) {
+                    ret.type = ColumnType::STRING;
+                    ret.owned_strings = {value.get<std::string>()};
+                    ret.strings = ret.owned_strings.data();
+                } else {
+                    throw UnsupportedColumnStage();
+                }
+
+                return ret;
+            }
+
+            template <typename Operator>
+            ColumnVector Arithmetic(const ColumnVector& left, const ColumnVector& right) {
+                if (left.type != ColumnType::NUMERIC || right.type != ColumnType::NUMERIC) {
+                    if (left.type == ColumnType::STRING || right.type == ColumnType::STRING) {
+                        // string concatenation of the + operator.
+                        throw UnsupportedColumnStage();
+                    }
+                    return this->MakeFailed(ColumnType::NUMERIC);
+                }
+
+                ColumnVector ret;
+                ret.owned_numbers.resize(this->rows_);
+                RunBinaryLoop<NumericLoop, Operator>(this->level_, left.numbers, left.scalar, right.numbers, right.scalar,
+                    ret.owned_numbers.data(), this->rows_);
+                ret.numbers = ret.owned_numbers.data();
+                ret.nulls = this->zeros_.data();
+                ret.owned_failed = this->FailedOperands(left, right);
+                ret.failed = ret.owned_failed.data();
+                return ret;
+            }
+
+            template <typename Operator, typename StringCompare>
+            ColumnVector Compare(const ColumnVector& left, const ColumnVector& right, StringCompare compare) {
+                ColumnVector ret;
+                ret.type = ColumnType::BOOLEAN;
+                ret.owned_booleans.resize(this->rows_);
+
+                if (left.type == ColumnType::NUMERIC && right.type == ColumnType::NUMERIC) {
+                    RunBinaryLoop<CompareLoop, Operator>(this->level_, left.numbers, left.scalar, right.numbers, right.scalar,
+                        ret.owned_booleans.data(), this->rows_);
+                } else if (left.type == ColumnType::STRING && right.type == ColumnType::STRING) {
+                    for (size_t row = 0; row < this->rows_; row++) {
+                        ret.owned_booleans[row] = compare(left.strings[left.scalar ? 0 : row], right.strings[right.scalar ? 0 : row]);
+                    }
+                } else {
+                    return this->MakeFailed(ColumnType::BOOLEAN);
+                }
+
+                ret.booleans = ret.owned_booleans.data();
+                ret.nulls = this->zeros_.data();
+                ret.owned_failed = this->FailedOperands(left, right);
+                ret.failed = ret.owned_failed.data();
+                return ret;
+            }
+
+            ColumnVector Equal(const ColumnVector& left, const ColumnVector& right, bool negate) {
+                ColumnVector ret;
+                ret.type = ColumnType::BOOLEAN;
+                std::vector<uint8_t> equal(this->rows_, 0);
+
+                if (left.type == right.type) {
+                    switch (left.type) {
+                        case ColumnType::NUMERIC:
+                            RunBinaryLoop<CompareLoop, EqualNumbers>(this->level_, left.numbers, left.scalar,
+                                right.numbers, right.scalar, equal.data(), this->rows_);
+                            break;
+                        case ColumnType::BOOLEAN:
+                            for (size_t row = 0; row < this->rows_; row++) {
+                                equal[row] = left.booleans[left.scalar ? 0 : row] == right.booleans[right.scalar ? 0 : row];
+                            }
+                            break;
+                        default:
+                            for (size_t row = 0; row < this->rows_; row++) {
+                                equal[row] = left.strings[left.scalar ? 0 : row] == right.strings[right.scalar ? 0 : row];
+                            }
+                            break;
+                    }
+                }
+
+                // null is only equal to null, and values of different types are never equal.
+                ret.owned_booleans.resize(this->rows_);
+                Dispatch<EqualNullsLoop>::Run(this->level_, static_cast<const uint8_t*>(equal.data()), left.nulls, right.nulls,
+                    ret.owned_booleans.data(), this->rows_);
+
+                if (negate) {
+                    for (auto& value: ret.owned_booleans) {
+                        value = !value;
+                    }
+                }
+
+                ret.booleans = ret.owned_booleans.data();
+                ret.nulls = this->zeros_.data();
+                ret.owned_failed.resize(this->rows_);
+                Dispatch<OrMaskLoop>::Run(this->level_, left.failed, right.failed, ret.owned_failed.data(), this->rows_);
+                ret.failed = ret.owned_failed.data();
+                return ret;
+            }
+
+            // A boolean operand of a logical operator, failing the rows where it isn't a bool.
+            ColumnVector LogicalOperand(ColumnVector vector) {
+                if (vector.type != ColumnType::BOOLEAN) {
+                    return this->MakeFailed(ColumnType::BOOLEAN);
+                }
+
+                if (vector.scalar) {
+                    vector = this->Broadcast(vector);
+                }
+
+                ColumnVector ret;
+                ret.type = ColumnType::BOOLEAN;
+                ret.owned_failed.resize(this->rows_);
+                Dispatch<OrMaskLoop>::Run(this->level_, vector.failed, vector.nulls, ret.owned_failed.data(), this->rows_);
+                ret.failed = ret.owned_failed.data();
+                ret.nulls = this->zeros_.data();
+                ret.owned_booleans = std::move(vector.owned_booleans);
+                ret.booleans = ret.owned_booleans.empty() ? vector.booleans : ret.owned_booleans.data();
+                return ret;
+            }
+
+            template <bool kDecidingValue>
+            ColumnVector Logical(ColumnVector left, ColumnVector right) {
+                left = this->LogicalOperand(std::move(left));
+                right = this->LogicalOperand(std::move(right));
+
+                ColumnVector ret;
+                ret.type = ColumnType::BOOLEAN;
+                ret.owned_booleans.resize(this->rows_);
+                ret.owned_failed.resize(this->rows_);
+                Dispatch<LogicalLoop<kDecidingValue>>::Run(this->level_, left.booleans, left.failed, right.booleans, right.failed,
+                    ret.owned_booleans.data(), ret.owned_failed.data(), this->rows_);
+                ret.booleans = ret.owned_booleans.data();
+                ret.failed = ret.owned_failed.data();
+                ret.nulls = this->zeros_.data();
+                return ret;
+            }
+
+            ColumnVector Unary(OperatorSymbol symbol, ColumnVector operand) {
+                auto type = symbol == OperatorSymbol::NEGATE ? ColumnType::NUMERIC : ColumnType::BOOLEAN;
+
+                if (operand.type != type) {
+                    return this->MakeFailed(type);
+                }
+
+                if (operand.scalar) {
+                    operand = this->Broadcast(operand);
+                }
+
+                ColumnVector ret;
+                ret.type = type;
+
+                if (type == ColumnType::NUMERIC) {
+                    ret.owned_numbers.resize(this->rows_);
+                    for (size_t row = 0; row < this->rows_; row++) {
+                        ret.owned_numbers[row] = -operand.numbers[row];
+                    }
+                    ret.numbers = ret.owned_numbers.data();
+                } else {
+                    ret.owned_booleans.resize(this->rows_);
+                    for (size_t row = 0; row < this->rows_; row++) {
+                        ret.owned_booleans[row] = !operand.booleans[row];
+                    }
+                    ret.booleans = ret.owned_booleans.data();
+                }
+
+                ret.nulls = this->zeros_.data();
+                ret.owned_failed.resize(this->rows_);
+                Dispatch<OrMaskLoop>::Run(this->level_, operand.failed, operand.nulls, ret.owned_failed.data(), this->rows_);
+                ret.failed = ret.owned_failed.data();
+                return ret;
+            }
+        public:
+            ColumnEvaluator(const ColumnBatch& batch, SimdLevel level) :
+                batch_(batch), level_(level), rows_(batch.Rows()), zeros_(batch.Rows(), 0) {};
+
+            ColumnVector Evaluate(const std::shared_ptr<EvaluationStage>& stage) {
+                if (stage == nullptr) {
+                    throw UnsupportedColumnStage();
+                }
+
+                switch (stage->symbol_) {
+                    case OperatorSymbol::LITERAL:
+                        return this->Literal(stage->value_);
+                    case OperatorSymbol::VALUE:
+                        return this->Load(stage->value_.get<std::string>());
+                    case OperatorSymbol::ACCESS:
+                        return this->Load(GetAccessorName(stage->value_));
+                    case OperatorSymbol::NOOP:
+                        return this->Evaluate(stage->right_stage_);
+                    case OperatorSymbol::NEGATE:
+                    case OperatorSymbol::INVERT:
+                        return this->Unary(stage->symbol_, this->Evaluate(stage->right_stage_));
+                    default:
+                        break;
+                }
+
+                switch (stage->symbol_) {
+                    case OperatorSymbol::PLUS:
+                    case OperatorSymbol::MINUS:
+                    case OperatorSymbol::MULTIPLY:
+                    case OperatorSymbol::DIVIDE:
+                    case OperatorSymbol::GTE:
+                    case OperatorSymbol::GT:
+                    case OperatorSymbol::LTE:
+                    case OperatorSymbol::LT:
+                    case OperatorSymbol::EQ:
+                    case OperatorSymbol::NEQ:
+                    case OperatorSymbol::AND:
+                    case OperatorSymbol::OR:
+                        break;
+                    default:
+                        throw UnsupportedColumnStage();
+                }
+
+                auto left = this->Evaluate(stage->left_stage_);
+                auto right = this->Evaluate(stage->right_stage_);
+
+                switch (stage->symbol_) {
+                    case OperatorSymbol::PLUS: return this->Arithmetic<AddNumbers>(left, right);
+                    case OperatorSymbol::MINUS: return this->Arithmetic<SubtractNumbers>(left, right);
+                    case OperatorSymbol::MULTIPLY: return this->Arithmetic<MultiplyNumbers>(left, right);
+                    case OperatorSymbol::DIVIDE: return this->Arithmetic<DivideNumbers>(left, right);
+                    case OperatorSymbol::GTE: return this->Compare<GteNumbers>(left, right, std::greater_equal<std::string>());
+                    case OperatorSymbol::GT: return this->Compare<GtNumbers>(left, right, std::greater<std::string>());
+                    case OperatorSymbol::LTE: return this->Compare<LteNumbers>(left, right, std::less_equal<std::string>());
+                    case OperatorSymbol::LT: return this->Compare<LtNumbers>(left, right, std::less<std::string>());
+                    case OperatorSymbol::EQ: return this->Equal(left, right, false);
+                    case OperatorSymbol::NEQ: return this->Equal(left, right, true);
+                    case OperatorSymbol::AND: return this->Logical<false>(std::move(left), std::move(right));
+                    default: return this->Logical<true>(std::move(left), std::move(right));
+                }
+            }
+
+            static std::string GetAccessorName(const TokenAvaiableData& names) {
+                std::string ret;
+
+                for (auto& name: names) {
+                    ret += (ret.empty() ? "" : ".") + name.get<std::string>();
+                }
+
+                return ret;
+            }
+
+            Column ToColumn(ColumnVector vector) {
+                if (vector.scalar) {
+                    vector = this->Broadcast(vector);
+                }
+
+                Bitmap nulls(this->rows_);
+                for (size_t row = 0; row < this->rows_; row++) {
+                    if (vector.nulls[row] | vector.failed[row]) {
+                        nulls.Set(row, true);
+                    }
+                }
+
+                switch (vector.type) {
+                    case ColumnType::NUMERIC:
+                        return Column::Numeric(std::vector<float>(vector.numbers, vector.numbers + this->rows_), std::move(nulls));
+                    case ColumnType::BOOLEAN:
+                        return Column::Boolean(std::vector<uint8_t>(vector.booleans, vector.booleans + this->rows_), std::move(nulls));
+                    default:
+                        return Column::String(std::vector<std::string>(vector.strings, vector.strings + this->rows_), std::move(nulls));
+                }
+            }
+    };
+
+    static void CheckColumns(const std::shared_ptr<EvaluationStage>& stage, const ColumnBatch& batch) {
+        if (stage == nullptr) {
+            return;
+        }
+
+        std::string name;
+
+        if (stage->symbol_ == OperatorSymbol::VALUE) {
+            name = stage->value_.get<std::string>();
+        } else if (stage->symbol_ == OperatorSymbol::ACCESS) {
+            name = ColumnEvaluator::GetAccessorName(stage->value_);
+        }
+
+        if (!name.empty() && batch.Find(name) == nullptr) {
+            throw CvaluateException("Cant' find column " + name);
+        }
+
+        CheckColumns(stage->left_stage_, batch);
+        CheckColumns(stage->right_stage_, batch);
+    }
+
+    static Column EvaluateRows(const ColumnBatch& batch, const RowEvaluator& row_evaluator) {
+        std::vector<TokenAvaiableData> results(batch.Rows());
+        Bitmap nulls(batch.Rows());
+        auto type = nlohmann::json::value_t::null;
+
+        for (size_t row = 0; row < batch.Rows(); row++) {
+            try {
+                results[row] = row_evaluator(batch.GetRow(row));
+            } catch (const std::exception&) {
+                results[row] = nullptr;
+            }
+
+            if (results[row].is_null()) {
+                nulls.Set(row, true);
+                continue;
+            }
+
+            auto row_type = results[row].is_number() ? nlohmann::json::value_t::number_float : results[row].type();
+            if (type != nlohmann::json::value_t::null && type != row_type) {
+                throw CvaluateException("Columnar results must share one type");
+            }
+            type = row_type;
+        }
+
+        switch (type) {
+            case nlohmann::json::value_t::number_float: {
+                std::vector<float> values(batch.Rows());
+                for (size_t row = 0; row < batch.Rows(); row++) {
+                    values[row] = nulls.Get(row) ? 0 : GetTokenValueNumeric(results[row]);
+                }
+                return Column::Numeric(std::move(values), std::move(nulls));
+            }
+            case nlohmann::json::value_t::string: {
+                std::vector<std::string> values(batch.Rows());
+                for (size_t row = 0; row < batch.Rows(); row++) {
+                    values[row] = nulls.Get(row) ? "" : results[row].get<std::string>();
+                }
+                return Column::String(std::move(values), std::move(nulls));
+            }
+            case nlohmann::json::value_t::boolean:
+            case nlohmann::json::value_t::null: {
+                std::vector<uint8_t> values(batch.Rows());
+                for (size_t row = 0; row < batch.Rows(); row++) {
+                    values[row] = !nulls.Get(row) && results[row].get<bool>();
+                }
+                return Column::Boolean(std::move(values), std::move(nulls));
+            }
+            default:
+                throw CvaluateException("Columnar results must be numeric, boolean or string");
+        }
+    }
+
+    Column EvaluateColumns(const std::shared_ptr<EvaluationStage>& root_stage, const ColumnBatch& batch,
+            SimdLevel level, const RowEvaluator& row_evaluator) {
+        CheckColumns(root_stage, batch);
+
+        // never run instructions the CPU doesn't have.
+        level = std::min(level, DetectSimdLevel());
+
+        ColumnEvaluator evaluator(batch, level);
+
+        try {
+            return evaluator.ToColumn(evaluator.Evaluate(root_stage));
+        } catch (const UnsupportedColumnStage&) {
+            return EvaluateRows(batch, row_evaluator);
+        }
+    }
+} // Cvaluate
@@ -0,0 +1,288 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <cvaluate/DecisionDiagram.h>
+#include <cvaluate/Exception.h>
+
+namespace Cvaluate {
+    /*
+        Builds the diagram with the usual if-then-else construction: a unique table keeps one node per
+        (predicate, low, high), so equal functions end up as the same node, and a node whose branches are equal
+        is never made.
+    */
+    class DiagramBuilder {
+        private:
+            struct Triple {
+                uint32_t first;
+                uint32_t second;
+                uint32_t third;
+
+                bool operator==(const Triple& other) const {
+                    return this->first == other.first && this->second == other.second && this->third == other.third;
+                }
+            };
+
+            struct TripleHash {
+                size_t operator()(const Triple& triple) const {
+                    auto hash = static_cast<size_t>(triple.first) * 0x9E3779B1u;
+                    hash = (hash ^ triple.second) * 0x85EBCA6Bu;
+                    return (hash ^ triple.third) * 0xC2B2AE35u;
+                }
+            };
+
+            DecisionDiagram& diagram_;
+            size_t node_limit_;
+            std::unordered_map<Triple, uint32_t, TripleHash> unique_nodes_;
+            std::unordered_map<Triple, uint32_t, TripleHash> computed_nodes_;
+            std::unordered_map<const EvaluationStage*, uint32_t> converted_stages_;
+            std::unordered_map<const EvaluationStage*, uint32_t> predicate_indexes_;
+
+            // The two results test no predicate, they sort after every predicate.
+            uint32_t Top(uint32_t node) const {
+                return this->diagram_.nodes_[node].predicate;
+            }
+
+            uint32_t Branch(uint32_t node, uint32_t predicate, bool value) const {
+                auto& decision = this->diagram_.nodes_[node];
+                if (decision.predicate != predicate) {
+                    return node;
+                }
+
+                return value ? decision.high : decision.low;
+            }
+
+            uint32_t MakeNode(uint32_t predicate, uint32_t low, uint32_t high) {
+                if (low == high) {
+                    return low;
+                }
+
+                auto node = this->unique_nodes_.emplace(Triple{predicate, low, high},
+                    static_cast<uint32_t>(this->diagram_.nodes_.size()));
+                if (node.second) {
+                    // the two results aren't counted.
+                    if (this->diagram_.nodes_.size() - 2 >= this->node_limit_) {
+                        throw CvaluateException("Decision diagram has more than " + std::to_string(this->node_limit_) + " nodes");
+                    }
+
+                    this->diagram_.nodes_.push_back({predicate, low, high});
+                }
+
+                return node.first->second;
+            }
+
+            uint32_t IfThenElse(uint32_t condition, uint32_t then_node, uint32_t else_node) {
+                if (condition == DecisionDiagram::kTrue || then_node == else_node) {
+                    return then_node;
+                }
+                if (condition == DecisionDiagram::kFalse) {
+                    return else_node;
+                }
+                if (then_node == DecisionDiagram::kTrue && else_node == DecisionDiagram::kFalse) {
+                    return condition;
+                }
+
+                Triple key{condition, then_node, else_node};
+                auto computed = this->computed_nodes_.find(key);
+                if (computed != this->computed_nodes_.end()) {
+                    return computed->second;
+                }
+
+                auto predicate = std::min({this->Top(condition), this->Top(then_node), this->Top(else_node)});
+                auto low = this->IfThenElse(this->Branch(condition, predicate, false),
+                    this->Branch(then_node, predicate, false), this->Branch(else_node, predicate, false));
+                auto high = this->IfThenElse(this->Branch(condition, predicate, true),
+                    this->Branch(then_node, predicate, true), this->Branch(else_node, predicate, true));
+                auto node = this->MakeNode(predicate, low, high);
+
+                this->computed_nodes_.emplace(key, node);
+                return node;
+            }
+
+            uint32_t MakePredicate(const std::shared_ptr<EvaluationStage>& stage) {
+                auto index = this->predicate_indexes_.emplace(stage.get(),
+                    static_cast<uint32_t>(this->diagram_.predicates_.size()));
+                if (index.second) {
+                    this->diagram_.predicates_.push_back(stage);
+                }
+
+                return this->MakeNode(index.first->second, DecisionDiagram::kFalse, DecisionDiagram::kTrue);
+            }
+        public:
+            DiagramBuilder(DecisionDiagram& diagram, size_t node_limit) : diagram_(diagram), node_limit_(node_limit) {
+                auto results = std::numeric_limits<uint32_t>::max();
+                diagram.nodes_.push_back({results, DecisionDiagram::kFalse, DecisionDiagram::kFalse});
+                diagram.nodes_.push_back({results, DecisionDiagram::kTrue, DecisionDiagram::kTrue});
+            }
+
+            /*
+                Predicates are numbered in the order they are first reached, left operands first,
+                which keeps the tests close to the order short-circuiting would make them.
+            */
+            uint32_t Convert(const std::shared_ptr<EvaluationStage>& stage) {
+                auto converted = this->converted_stages_.find(stage.get());
+                if (converted != this->converted_stages_.end()) {
+                    return converted->second;
+                }
+
+                uint32_t node;
+
+                switch (stage->symbol_) {
+                    case OperatorSymbol::AND: {
+                        auto left = this->Convert(stage->left_stage_);
+                        node = this->IfThenElse(left, this->Convert(stage->right_stage_), DecisionDiagram::kFalse);
+                        break;
+                    }
+                    case OperatorSymbol::OR: {
+                        auto left = this->Convert(stage->left_stage_);
+                        node = this->IfThenElse(left, DecisionDiagram::kTrue, this->Convert(stage->right_stage_));
+                        break;
+                    }
+                    case OperatorSymbol::INVERT:
+                        node = this->IfThenElse(this->Convert(stage->right_stage_), DecisionDiagram::kFalse,
+                            DecisionDiagram::kTrue);
+                        break;
+                    default:
+                        if (stage->symbol_ == OperatorSymbol::LITERAL && stage->value_.is_boolean()) {
+                            node = stage->value_.get<bool>() ? DecisionDiagram::kTrue : DecisionDiagram::kFalse;
+                            break;
+                        }
+
+                        node = this->MakePredicate(stage);
+                        break;
+                }
+
+                this->converted_stages_.emplace(stage.get(), node);
+                return node;
+            }
+
+            /*
+                Building leaves behind nodes of intermediate results that no root reaches.
+                Keep only the reachable ones, numbered depth first from the roots so one path stays close in memory.
+            */
+            void Compact(std::vector<uint32_t>& roots) {
+                auto& nodes = this->diagram_.nodes_;
+                std::vector<uint32_t> numbers(nodes.size(), 0);
+                std::vector<DecisionDiagram::DecisionNode> compacted(nodes.begin(), nodes.begin() + 2);
+                numbers[DecisionDiagram::kFalse] = DecisionDiagram::kFalse;
+                numbers[DecisionDiagram::kTrue] = DecisionDiagram::kTrue;
+
+                std::function<uint32_t(uint32_t)> renumber = [&](uint32_t node) -> uint32_t {
+                    if (node <= DecisionDiagram::kTrue || numbers[node] != 0) {
+                        return numbers[node];
+                    }
+
+                    auto number = static_cast<uint32_t>(compacted.size());
+                    numbers[node] = number;
+                    compacted.push_back(nodes[node]);
+                    auto low = renumber(nodes[node].low);
+                    auto high = renumber(nodes[node].high);
+                    compacted[number].low = low;
+                    compacted[number].high = high;
+                    return number;
+                };
+
+                for (auto& root: roots) {
+                    root = renumber(root);
+                }
+
+                nodes = std::move(compacted);
+                this->unique_nodes_.clear();
+                this->computed_nodes_.clear();
+            }
+    };
+
+    /*
+        The expressions are planned and merged like an `ExpressionSet`, so equal predicates are the same stage.
+        Only the predicates are evaluated afterwards, so only their subtrees are numbered for sharing.
+    */
+    DecisionDiagram::DecisionDiagram(const std::vector<std::string>& expressions, const ExpressionFunctionMap& functions,
+            const ParameterSchema& schema, size_t node_limit) {
+        for (auto& expression: expressions) {
+            auto tokens = ParseTokens(expression, functions);
+            auto stage = PlanStages(tokens, nullptr, schema);
+
+            if (stage == nullptr) {
+                throw CvaluateException("Found empty stage.");
+            }
+
+            this->stages_.push_back(stage);
+        }
+
+        EliminateCommonStages(this->stages_);
+
+        DiagramBuilder builder(*this, node_limit);
+        for (auto& stage: this->stages_) {
+            this->roots_.push_back(builder.Convert(stage));
+        }
+        builder.Compact(this->roots_);
+
+        this->shared_stages_ = NumberSharedStages(this->predicates_);
+    }
+
+    size_t DecisionDiagram::Size() const {
+        return this->roots_.size();
+    }
+
+    size_t DecisionDiagram::Predicates() const {
+        return this->predicates_.size();
+    }
+
+    size_t DecisionDiagram::Nodes() const {
+        return this->nodes_.size() - 2;
+    }
+
+    /*
+        [tested] keeps each predicate's result for this evaluation, -1 until it is tested.
+    */
+    bool DecisionDiagram::Follow(uint32_t node, const Parameters& parameters, std::vector<int8_t>& tested,
+            SharedStageResults& shared) const {
+        while (node > kTrue) {
+            auto& decision = this->nodes_[node];
+            auto& result = tested[decision.predicate];
+
+            if (result < 0) {
+                auto value = EvaluateStageTree(this->predicates_[decision.predicate].get(), parameters, shared);
+                result = GetTokenValueBool(value) ? 1 : 0;
+            }
+
+            node = result ? decision.high : decision.low;
+        }
+
+        return node == kTrue;
+    }
+
+    std::vector<bool> DecisionDiagram::Evaluate(const Parameters& parameters) const {
+        std::vector<bool> results;
+        results.reserve(this->roots_.size());
+        std::vector<int8_t> tested(this->predicates_.size(), -1);
+        SharedStageResults shared(this->shared_stages_);
+
+        for (auto root: this->roots_) {
+            results.push_back(this->Follow(root, parameters, tested, shared));
+        }
+
+        return results;
+    }
+
+    bool DecisionDiagram::Evaluate(const Parameters& parameters, size_t index) const {
+        if (index >= this->roots_.size()) {
+            throw CvaluateException("Expression index out of range");
+        }
+
+        std::vector<int8_t> tested(this->predicates_.size(), -1);
+        SharedStageResults shared(this->shared_stages_);
+        return this->Follow(this->roots_[index], parameters, tested, shared);
+    }
+} // Cvaluate
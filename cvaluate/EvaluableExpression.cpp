@@ -17,43 +17,401 @@
 #include <cvaluate/EvaluableExpression.h>
 #include <cvaluate/Exception.h>
 
+#include <exception>
+#include <type_traits>
+
 namespace Cvaluate {
 
 EvaluableExpression::EvaluableExpression(std::string expression, 
-            ExpressionFunctionMap functions) {
+            ExpressionFunctionMap functions, const ParameterSchema& schema) {
     this->e_input = expression;
 
     this->e_tokens = ParseTokens(expression, functions);
 
-    this->e_evaluation_stage = PlanStages(this->e_tokens);
+    this->e_evaluation_stage = PlanStages(this->e_tokens, &this->e_statistics, schema);
+
+    // variable slots are assigned here, so they are known before the first evaluation.
+    this->e_program = std::make_shared<ByteCodeProgram>(CompileStages(this->e_evaluation_stage));
 };
 
 std::vector<ExpressionToken> EvaluableExpression::Tokens() {
     return this->e_tokens;
 }
 
-TokenAvaiableData EvaluableExpression::Evaluate(Parameters params) {
+const PlanStatistics& EvaluableExpression::Statistics() const {
+    return this->e_statistics;
+}
+
+const EvaluationStage* EvaluableExpression::Stages() const {
+    return this->e_evaluation_stage.get();
+}
 
-    return EvaluateStage(this->e_evaluation_stage, params);
+const std::vector<std::string>& EvaluableExpression::ParameterSlots() const {
+    return this->e_program->slots;
 }
 
-TokenAvaiableData EvaluableExpression::EvaluateStage(std::shared_ptr<EvaluationStage> stage, Parameters params) {
-    TokenAvaiableData left, right;
-    if (stage == nullptr) {
-        throw Cvaluate::CvaluateException("Found empty stage.");
+int EvaluableExpression::FindParameterSlot(const std::string& name) const {
+    auto& slots = this->e_program->slots;
+    auto slot = std::find(slots.begin(), slots.end(), name);
+
+    if (slot == slots.end()) {
+        return -1;
     }
 
-    if (stage != nullptr && stage->left_stage_) {
-        left = this->EvaluateStage(stage->left_stage_, params);
+    return slot - slots.begin();
+}
+
+ParameterFrame EvaluableExpression::MakeParameterFrame() const {
+    return ParameterFrame(this->e_program->slots.size());
+}
+
+void EvaluableExpression::SetEvaluationMode(EvaluationMode mode) {
+    if (mode == EvaluationMode::CLOSURE && this->e_closure == nullptr) {
+        this->e_closure = CompileClosures(this->e_evaluation_stage, this->e_program->slots);
     }
 
-    if (stage != nullptr && stage->right_stage_) {
-        right = this->EvaluateStage(stage->right_stage_, params);
+    this->e_mode = mode;
+}
+
+EvaluationMode EvaluableExpression::GetEvaluationMode() const {
+    return this->e_mode;
+}
+
+TokenAvaiableData EvaluableExpression::Evaluate(const Parameters& params) const {
+    if (this->e_mode == EvaluationMode::BYTECODE) {
+        VirtualMachine machine;
+        return machine.Execute(*this->e_program, params);
     }
 
-    auto ans = stage->operator_(left, right, params);
+    if (this->e_mode == EvaluationMode::CLOSURE) {
+        return this->e_closure->Execute(BindParameters(this->e_program->slots, params));
+    }
+
+    SharedStageResults shared(this->e_statistics.shared_stages);
+    return EvaluateStageTree(this->e_evaluation_stage.get(), params, shared);
+}
+
+TokenAvaiableData EvaluableExpression::Evaluate(const ParameterFrame& frame) const {
+    if (this->e_mode == EvaluationMode::CLOSURE) {
+        return this->e_closure->Execute(frame);
+    }
+
+    VirtualMachine machine;
+    return machine.Execute(*this->e_program, frame);
+}
+
+void EvaluableExpression::EvaluateBatch(const Parameters* rows, size_t count, TokenAvaiableData* results) const {
+    this->EvaluateRows(rows, count, results);
+}
+
+void EvaluableExpression::EvaluateBatch(const Parameters* rows, size_t count, bool* results) const {
+    this->EvaluateRows(rows, count, results);
+}
+
+std::vector<TokenAvaiableData> EvaluableExpression::EvaluateBatch(const std::vector<Parameters>& rows) const {
+    std::vector<TokenAvaiableData> results(rows.size());
+    this->EvaluateRows(rows.data(), rows.size(), results.data());
+
+    return results;
+}
+
+void EvaluableExpression::EvaluateBatchParallel(const Parameters* rows, size_t count, TokenAvaiableData* results,
+            Executor& executor, size_t chunk_size) const {
+    this->EvaluateRowsParallel(rows, count, results, executor, chunk_size);
+}
+
+void EvaluableExpression::EvaluateBatchParallel(const Parameters* rows, size_t count, bool* results,
+            Executor& executor, size_t chunk_size) const {
+    this->EvaluateRowsParallel(rows, count, results, executor, chunk_size);
+}
+
+std::vector<TokenAvaiableData> EvaluableExpression::EvaluateBatchParallel(const std::vector<Parameters>& rows,
+            Executor& executor) const {
+    std::vector<TokenAvaiableData> results(rows.size());
+    this->EvaluateBatchParallel(rows.data(), rows.size(), results.data(), executor);
+
+    return results;
+}
+
+Column EvaluableExpression::EvaluateColumns(const ColumnBatch& batch, SimdLevel level) const {
+    return Cvaluate::EvaluateColumns(this->e_evaluation_stage, batch, level, [this](const Parameters& parameters) {
+        return this->Evaluate(parameters);
+    });
+}
+
+/*
+    The row loop of every evaluation mode: the compiled modes rebind one frame per row
+    and keep their stack and arena across rows, so only the first row pays for their allocation.
+    [visit] receives each row's index and result, and stops the loop by returning false.
+*/
+template <typename Result, typename Visitor>
+void EvaluableExpression::VisitRows(const Parameters* rows, size_t count, Visitor visit) const {
+    constexpr bool kBoolResults = std::is_same<Result, bool>::value;
+
+    if (this->e_mode == EvaluationMode::TREE_WALK) {
+        SharedStageResults shared;
+
+        for (size_t i = 0; i < count; i++) {
+            shared.assign(this->e_statistics.shared_stages, std::nullopt);
+            bool next;
+            if constexpr (kBoolResults) {
+                next = visit(i, GetTokenValueBool(EvaluateStageTree(this->e_evaluation_stage.get(), rows[i], shared)));
+            } else {
+                next = visit(i, EvaluateStageTree(this->e_evaluation_stage.get(), rows[i], shared));
+            }
+
+            if (!next) {
+                return;
+            }
+        }
+        return;
+    }
+
+    auto& slots = this->e_program->slots;
+    auto frame = this->MakeParameterFrame();
+
+    if (this->e_mode == EvaluationMode::BYTECODE) {
+        VirtualMachine machine;
+
+        for (size_t i = 0; i < count; i++) {
+            BindParameters(frame, slots, rows[i]);
+            bool next;
+            if constexpr (kBoolResults) {
+                next = visit(i, machine.ExecuteBool(*this->e_program, frame));
+            } else {
+                next = visit(i, machine.Execute(*this->e_program, frame));
+            }
+
+            if (!next) {
+                return;
+            }
+        }
+        return;
+    }
+
+    ValueArena arena;
+
+    for (size_t i = 0; i < count; i++) {
+        BindParameters(frame, slots, rows[i]);
+        bool next;
+        if constexpr (kBoolResults) {
+            next = visit(i, this->e_closure->ExecuteBool(frame, arena));
+        } else {
+            next = visit(i, this->e_closure->Execute(frame, arena));
+        }
+
+        if (!next) {
+            return;
+        }
+    }
+}
+
+template <typename Result>
+void EvaluableExpression::EvaluateRows(const Parameters* rows, size_t count, Result* results) const {
+    this->VisitRows<Result>(rows, count, [results](size_t i, Result result) {
+        results[i] = std::move(result);
+        return true;
+    });
+}
+
+/*
+    Chunks are claimed from a shared counter in row order, so threads that start late or run slowly simply take fewer of them.
+    The calling thread claims chunks too and never waits on a task the executor hasn't started,
+    which keeps it from blocking when the executor is busy; tasks that start after every chunk is claimed return at once.
+    The state lives on the heap for those late tasks, they must not touch the stack of a call that has returned.
+    [run_chunk] gets the first row and the size of each chunk. If it throws, the remaining chunks are skipped
+    and the first exception is thrown once the running chunks are done.
+*/
+template <typename Chunk>
+static void RunChunksParallel(size_t count, size_t chunk_size, Executor& executor, Chunk run_chunk) {
+    if (chunk_size == 0) {
+        throw CvaluateException("Chunk size must be positive");
+    }
+
+    auto chunks = (count + chunk_size - 1) / chunk_size;
+
+    if (chunks <= 1) {
+        run_chunk(0, count);
+        return;
+    }
+
+    struct ParallelBatch {
+        std::atomic<size_t> next_chunk{0};
+        std::atomic<bool> failed{false};
+        std::mutex mutex;
+        std::condition_variable done;
+        size_t finished_chunks = 0;
+        std::exception_ptr error;
+    };
+
+    auto batch = std::make_shared<ParallelBatch>();
+    auto run = [batch, run_chunk, count, chunk_size, chunks] {
+        for (auto chunk = batch->next_chunk++; chunk < chunks; chunk = batch->next_chunk++) {
+            if (!batch->failed) {
+                auto begin = chunk * chunk_size;
+
+                try {
+                    run_chunk(begin, std::min(chunk_size, count - begin));
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(batch->mutex);
+                    if (!batch->error) {
+                        batch->error = std::current_exception();
+                    }
+                    batch->failed = true;
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(batch->mutex);
+            if (++batch->finished_chunks == chunks) {
+                batch->done.notify_all();
+            }
+        }
+    };
+
+    auto helpers = std::min(executor.Concurrency(), chunks - 1);
+    for (size_t i = 0; i < helpers; i++) {
+        executor.Submit(run);
+    }
+
+    run();
+
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->done.wait(lock, [&batch, chunks] { return batch->finished_chunks == chunks; });
+
+    if (batch->error) {
+        std::rethrow_exception(batch->error);
+    }
+}
+
+template <typename Result>
+void EvaluableExpression::EvaluateRowsParallel(const Parameters* rows, size_t count, Result* results,
+            Executor& executor, size_t chunk_size) const {
+    RunChunksParallel(count, chunk_size, executor, [this, rows, results](size_t begin, size_t size) {
+        this->EvaluateRows(rows + begin, size, results + begin);
+    });
+}
+
+/*
+    Return the first row whose result is [expected], or [count] if there is none.
+    A row failing before it throws, like evaluating the rows one by one would.
+*/
+size_t EvaluableExpression::FindRow(const Parameters* rows, size_t count, bool expected) const {
+    auto found = count;
+    this->VisitRows<bool>(rows, count, [&found, expected](size_t i, bool result) {
+        if (result != expected) {
+            return true;
+        }
+
+        found = i;
+        return false;
+    });
+
+    return found;
+}
+
+/*
+    `bound` is the first row known to decide the search, found or failing.
+    Chunks stop at it and chunks starting after it are skipped, which cancels the rows that can't change the outcome.
+    Rows before it are still evaluated, so the outcome and the exception thrown are those of the rows one by one.
+*/
+size_t EvaluableExpression::FindRowParallel(const Parameters* rows, size_t count, bool expected,
+            Executor& executor, size_t chunk_size) const {
+    struct ParallelSearch {
+        std::atomic<size_t> bound;
+        std::mutex mutex;
+        size_t failed_row;
+        std::exception_ptr error;
+    };
+
+    auto search = std::make_shared<ParallelSearch>();
+    search->bound = count;
+    search->failed_row = count;
+
+    auto narrow = [search](size_t row) {
+        auto bound = search->bound.load();
+        while (row < bound && !search->bound.compare_exchange_weak(bound, row)) {
+        }
+    };
+
+    RunChunksParallel(count, chunk_size, executor, [this, rows, expected, search, narrow](size_t begin, size_t size) {
+        if (begin >= search->bound) {
+            return;
+        }
+
+        auto row = begin;
+
+        try {
+            this->VisitRows<bool>(rows + begin, size, [&row, begin, expected, search, narrow](size_t i, bool result) {
+                row = begin + i;
+                if (result == expected) {
+                    narrow(row);
+                    return false;
+                }
+
+                return ++row < search->bound.load(std::memory_order_relaxed);
+            });
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(search->mutex);
+            if (row < search->failed_row) {
+                search->failed_row = row;
+                search->error = std::current_exception();
+            }
+            narrow(row);
+        }
+    });
+
+    if (search->error && search->failed_row == search->bound) {
+        std::rethrow_exception(search->error);
+    }
+
+    return search->bound;
+}
+
+size_t EvaluableExpression::CountRows(const Parameters* rows, size_t count) const {
+    size_t matches = 0;
+    this->VisitRows<bool>(rows, count, [&matches](size_t, bool result) {
+        matches += result;
+        return true;
+    });
+
+    return matches;
+}
+
+bool EvaluableExpression::EvaluateAny(const Parameters* rows, size_t count) const {
+    return this->FindRow(rows, count, true) < count;
+}
+
+bool EvaluableExpression::EvaluateAny(const Parameters* rows, size_t count, Executor& executor, size_t chunk_size) const {
+    return this->FindRowParallel(rows, count, true, executor, chunk_size) < count;
+}
+
+bool EvaluableExpression::EvaluateAll(const Parameters* rows, size_t count) const {
+    return this->FindRow(rows, count, false) == count;
+}
+
+bool EvaluableExpression::EvaluateAll(const Parameters* rows, size_t count, Executor& executor, size_t chunk_size) const {
+    return this->FindRowParallel(rows, count, false, executor, chunk_size) == count;
+}
+
+size_t EvaluableExpression::EvaluateFirst(const Parameters* rows, size_t count) const {
+    return this->FindRow(rows, count, true);
+}
+
+size_t EvaluableExpression::EvaluateFirst(const Parameters* rows, size_t count, Executor& executor, size_t chunk_size) const {
+    return this->FindRowParallel(rows, count, true, executor, chunk_size);
+}
+
+size_t EvaluableExpression::EvaluateCount(const Parameters* rows, size_t count) const {
+    return this->CountRows(rows, count);
+}
+
+size_t EvaluableExpression::EvaluateCount(const Parameters* rows, size_t count, Executor& executor, size_t chunk_size) const {
+    std::atomic<size_t> matches{0};
+    RunChunksParallel(count, chunk_size, executor, [this, rows, &matches](size_t begin, size_t size) {
+        matches += this->CountRows(rows + begin, size);
+    });
 
-    return ans;
+    return matches;
 }
 
 } // Cvaluate
\ No newline at end of file
@@ -15,9 +15,13 @@
 */
 #include <cvaluate/EvaluationStage.h>
 #include <cvaluate/Exception.h>
+#include <cvaluate/RegexCache.h>
+#include <cvaluate/MembershipSet.h>
 
 namespace Cvaluate {
-    TokenAvaiableData AddStage(TokenAvaiableData left, TokenAvaiableData right, Parameters) {
+    const Parameters kEmptyParameters;
+
+    TokenAvaiableData AddStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters&) {
         if (IsString(left) || IsString(right)) {
             return GetTokenValueString(left) + GetTokenValueString(right);
         }
@@ -25,57 +29,57 @@ namespace Cvaluate {
         return GetTokenValueNumeric(left) + GetTokenValueNumeric(right);
     }
 
-    TokenAvaiableData SubtractStage(TokenAvaiableData left, TokenAvaiableData right, Parameters) {
+    TokenAvaiableData SubtractStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters&) {
         return GetTokenValueNumeric(left) - GetTokenValueNumeric(right); 
     }
 
-    TokenAvaiableData MultiplyStage(TokenAvaiableData left, TokenAvaiableData right, Parameters) {
+    TokenAvaiableData MultiplyStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters&) {
         return GetTokenValueNumeric(left) * GetTokenValueNumeric(right);
     }
 
-    TokenAvaiableData DivideStage(TokenAvaiableData left, TokenAvaiableData right, Parameters) {
+    TokenAvaiableData DivideStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters&) {
         return GetTokenValueNumeric(left) / GetTokenValueNumeric(right);
     }
 
-    TokenAvaiableData ExponentStage(TokenAvaiableData left, TokenAvaiableData right, Parameters) {
+    TokenAvaiableData ExponentStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters&) {
         return (float)pow(GetTokenValueNumeric(left), GetTokenValueNumeric(right));
     }
 
-    TokenAvaiableData ModulusStage(TokenAvaiableData left, TokenAvaiableData right, Parameters) {
+    TokenAvaiableData ModulusStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters&) {
         return (float)((int)GetTokenValueNumeric(left) % (int)GetTokenValueNumeric(right));
     }
 
-    TokenAvaiableData GteStage(TokenAvaiableData left, TokenAvaiableData right, Parameters) {
+    TokenAvaiableData GteStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters&) {
         if (IsString(left) && IsString(right)) {
-            return GetTokenValueString(left) >= GetTokenValueString(right);
+            return left.get_ref<const std::string&>() >= right.get_ref<const std::string&>();
         }
         return GetTokenValueNumeric(left) >= GetTokenValueNumeric(right);
     }
 
-    TokenAvaiableData GtStage(TokenAvaiableData left, TokenAvaiableData right, Parameters) {
+    TokenAvaiableData GtStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters&) {
         if (IsString(left) && IsString(right)) {
-            return GetTokenValueString(left) > GetTokenValueString(right);
+            return left.get_ref<const std::string&>() > right.get_ref<const std::string&>();
         }
         return GetTokenValueNumeric(left) > GetTokenValueNumeric(right);
     }
 
-    TokenAvaiableData LteStage(TokenAvaiableData left, TokenAvaiableData right, Parameters) {
+    TokenAvaiableData LteStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters&) {
         if (IsString(left) && IsString(right)) {
-            return GetTokenValueString(left) <= GetTokenValueString(right);
+            return left.get_ref<const std::string&>() <= right.get_ref<const std::string&>();
         }
         return GetTokenValueNumeric(left) <= GetTokenValueNumeric(right);
     }
 
-    TokenAvaiableData LtStage(TokenAvaiableData left, TokenAvaiableData right, Parameters) {
+    TokenAvaiableData LtStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters&) {
         if (IsString(left) && IsString(right)) {
-            return GetTokenValueString(left) < GetTokenValueString(right);
+            return left.get_ref<const std::string&>() < right.get_ref<const std::string&>();
         }
         return GetTokenValueNumeric(left) < GetTokenValueNumeric(right);
     }
 
-    TokenAvaiableData EqualStage(TokenAvaiableData left, TokenAvaiableData right, Parameters) {
+    TokenAvaiableData EqualStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters&) {
         if (IsString(left) && IsString(right)) {
-            return GetTokenValueString(left) == GetTokenValueString(right);
+            return left.get_ref<const std::string&>() == right.get_ref<const std::string&>();
         }
 
         if (IsNumeric(left) && IsNumeric(right)) {
@@ -89,9 +93,9 @@ namespace Cvaluate {
         return left == right;
     }
 
-    TokenAvaiableData NotEqualStage(TokenAvaiableData left, TokenAvaiableData right, Parameters) {
+    TokenAvaiableData NotEqualStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters&) {
         if (IsString(left) && IsString(right)) {
-            return GetTokenValueString(left) != GetTokenValueString(right);
+            return left.get_ref<const std::string&>() != right.get_ref<const std::string&>();
         }
 
         if (IsNumeric(left) && IsNumeric(right)) {
@@ -105,72 +109,104 @@ namespace Cvaluate {
         return left != right;
     }
 
-    TokenAvaiableData AndStage(TokenAvaiableData left, TokenAvaiableData right, Parameters) {
+    TokenAvaiableData AndStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters&) {
         return GetTokenValueBool(left) && GetTokenValueBool(right);
     }
 
-    TokenAvaiableData OrStage(TokenAvaiableData left, TokenAvaiableData right, Parameters) {
+    TokenAvaiableData OrStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters&) {
         return GetTokenValueBool(left) || GetTokenValueBool(right);
     }
 
-    TokenAvaiableData NegateStage(TokenAvaiableData left, TokenAvaiableData right, Parameters) {
+    TokenAvaiableData NegateStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters&) {
         return -GetTokenValueNumeric(right);
     }
 
-    TokenAvaiableData InvertStage(TokenAvaiableData left, TokenAvaiableData right, Parameters) {
+    TokenAvaiableData InvertStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters&) {
         return !GetTokenValueBool(right);
     }
 
-    TokenAvaiableData BitwiseNotStage(TokenAvaiableData, TokenAvaiableData, Parameters) {
+    TokenAvaiableData BitwiseNotStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters&) {
         throw CvaluateException("BitwiseNotStage Not Implement");
     }
 
-    TokenAvaiableData TernaryIfStage(TokenAvaiableData, TokenAvaiableData, Parameters) {
-        throw CvaluateException("TernaryIfStage Not Implement");
+    TokenAvaiableData TernaryIfStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters&) {
+        if (GetTokenValueBool(left)) {
+            return right;
+        }
+
+        return nullptr;
     }
 
-    TokenAvaiableData TernaryElseStage(TokenAvaiableData, TokenAvaiableData, Parameters)  {
-        throw CvaluateException("TernaryElseStage Not Implement");
+    TokenAvaiableData TernaryElseStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters&)  {
+        if (!left.is_null()) {
+            return left;
+        }
+
+        return right;
     }
 
-    TokenAvaiableData RegexStage(TokenAvaiableData, TokenAvaiableData, Parameters) {
-        throw CvaluateException("RegexStage Not Implement");
+    static bool SearchRegex(const TokenAvaiableData& value, const std::regex& pattern) {
+        if (value.is_string()) {
+            return std::regex_search(value.get_ref<const std::string&>(), pattern);
+        }
+
+        return std::regex_search(GetTokenValueString(value), pattern);
     }
 
-    TokenAvaiableData NotRegexStage(TokenAvaiableData, TokenAvaiableData, Parameters) {
-        throw CvaluateException("NotRegexStage Not Implement");
+    // The pattern is only known at evaluation-time here, see `MakeRegexStage` for literal patterns.
+    TokenAvaiableData RegexStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters&) {
+        auto pattern = RegexCache::Default().Get(GetTokenValueString(right));
+
+        return SearchRegex(left, *pattern);
     }
 
-    TokenAvaiableData BitwiseOrStage(TokenAvaiableData, TokenAvaiableData, Parameters) {
+    TokenAvaiableData NotRegexStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters& parameters) {
+        return !GetTokenValueBool(RegexStage(left, right, parameters));
+    }
+
+    TokenAvaiableData BitwiseOrStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters&) {
         throw CvaluateException("BitwiseOrStage Not Implement");
     }
 
-    TokenAvaiableData BitwiseAndStage(TokenAvaiableData, TokenAvaiableData, Parameters) {
+    TokenAvaiableData BitwiseAndStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters&) {
         throw CvaluateException("BitwiseAndStage Not Implement");
     }
 
-    TokenAvaiableData BitwiseXORStage(TokenAvaiableData, TokenAvaiableData, Parameters) {
+    TokenAvaiableData BitwiseXORStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters&) {
         throw CvaluateException("BitwiseXORStage Not Implement");
     }
 
-    TokenAvaiableData LeftShiftStage(TokenAvaiableData, TokenAvaiableData, Parameters) {
+    TokenAvaiableData LeftShiftStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters&) {
         throw CvaluateException("LeftShiftStage Not Implement");
     }
-    TokenAvaiableData RightShiftStage(TokenAvaiableData, TokenAvaiableData, Parameters) {
+    TokenAvaiableData RightShiftStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters&) {
         throw CvaluateException("RightShiftStage Not Implement");
     }
 
-    TokenAvaiableData NoopStageRight(TokenAvaiableData left, TokenAvaiableData right, Parameters) {
+    TokenAvaiableData NoopStageRight(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters&) {
         return right;
     }
     
-    TokenAvaiableData InStage(TokenAvaiableData, TokenAvaiableData, Parameters) {
-        throw CvaluateException("InStage Not Implement");
+    // The array is only known at evaluation-time here, see `MakeMembershipStage` for literal arrays.
+    TokenAvaiableData InStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters&) {
+        if (!right.is_array()) {
+            throw CvaluateException("Value of 'in' must be an array");
+        }
+
+        if (IsNumeric(left)) {
+            // compared as floats, the same as `==`.
+            auto number = GetTokenValueNumeric(left);
+            return std::any_of(right.begin(), right.end(), [number] (const TokenAvaiableData& element) {
+                return IsNumeric(element) && GetTokenValueNumeric(element) == number;
+            });
+        }
+
+        return std::find(right.begin(), right.end(), left) != right.end();
     }
 
-    TokenAvaiableData SeparatorStage(TokenAvaiableData left, TokenAvaiableData right, Parameters) {
+    TokenAvaiableData SeparatorStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters&) {
         TokenAvaiableData ans;
-        if (left.is_object()) {
+        if (left.is_array()) {
             ans = left;
             ans.push_back(right);
         } else {
@@ -181,94 +217,220 @@ namespace Cvaluate {
         return ans;
     }
 
-    EvaluationOperator MakeParameterStage(std::string parameter_name) {
-        auto func = [] (TokenAvaiableData value, TokenAvaiableData, Parameters parameter, std::string name) -> TokenAvaiableData {
-            if(parameter.find(name) == parameter.end()) {
-                throw CvaluateException("Cant' find varibale name in parameter");
-            } else {
-                return parameter[name];
-            }
-        };
+    TokenAvaiableData NumericAddStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters& parameters) {
+        if (IsNumeric(left) && IsNumeric(right)) {
+            return GetTokenValueNumeric(left) + GetTokenValueNumeric(right);
+        }
+
+        return AddStage(left, right, parameters);
+    }
 
-        auto ret = std::bind(func, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, parameter_name);
+    TokenAvaiableData NumericGteStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters& parameters) {
+        if (IsNumeric(left) && IsNumeric(right)) {
+            return GetTokenValueNumeric(left) >= GetTokenValueNumeric(right);
+        }
 
-        return ret;
+        return GteStage(left, right, parameters);
     }
 
-    EvaluationOperator MakeLiteralStage(TokenAvaiableData value) {
-        auto func = [] (TokenAvaiableData value, TokenAvaiableData, Parameters) -> TokenAvaiableData {
-            return value;
-        };
+    TokenAvaiableData NumericGtStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters& parameters) {
+        if (IsNumeric(left) && IsNumeric(right)) {
+            return GetTokenValueNumeric(left) > GetTokenValueNumeric(right);
+        }
 
-        auto ret = std::bind(func, value, std::placeholders::_2, std::placeholders::_3);
+        return GtStage(left, right, parameters);
+    }
 
-        return ret;
+    TokenAvaiableData NumericLteStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters& parameters) {
+        if (IsNumeric(left) && IsNumeric(right)) {
+            return GetTokenValueNumeric(left) <= GetTokenValueNumeric(right);
+        }
+
+        return LteStage(left, right, parameters);
     }
 
-    EvaluationOperator MakeFunctionStage(ExpressionFunction function) {
-        auto func = [] (TokenAvaiableData, TokenAvaiableData right, Parameters, ExpressionFunction function) -> TokenAvaiableData {
-            return function(right);
-        };
+    TokenAvaiableData NumericLtStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters& parameters) {
+        if (IsNumeric(left) && IsNumeric(right)) {
+            return GetTokenValueNumeric(left) < GetTokenValueNumeric(right);
+        }
+
+        return LtStage(left, right, parameters);
+    }
+
+    TokenAvaiableData NumericEqualStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters& parameters) {
+        if (IsNumeric(left) && IsNumeric(right)) {
+            return GetTokenValueNumeric(left) == GetTokenValueNumeric(right);
+        }
+
+        return EqualStage(left, right, parameters);
+    }
+
+    TokenAvaiableData NumericNotEqualStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters& parameters) {
+        if (IsNumeric(left) && IsNumeric(right)) {
+            return GetTokenValueNumeric(left) != GetTokenValueNumeric(right);
+        }
+
+        return NotEqualStage(left, right, parameters);
+    }
+
+    TokenAvaiableData StringAddStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters& parameters) {
+        if (IsString(left) && IsString(right)) {
+            return left.get_ref<const std::string&>() + right.get_ref<const std::string&>();
+        }
+
+        return AddStage(left, right, parameters);
+    }
+
+    TokenAvaiableData StringEqualStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters& parameters) {
+        if (IsString(left) && IsString(right)) {
+            return left.get_ref<const std::string&>() == right.get_ref<const std::string&>();
+        }
+
+        return EqualStage(left, right, parameters);
+    }
+
+    TokenAvaiableData StringNotEqualStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters& parameters) {
+        if (IsString(left) && IsString(right)) {
+            return left.get_ref<const std::string&>() != right.get_ref<const std::string&>();
+        }
+
+        return NotEqualStage(left, right, parameters);
+    }
+
+    TokenAvaiableData BoolEqualStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters& parameters) {
+        if (IsBool(left) && IsBool(right)) {
+            return left.get<bool>() == right.get<bool>();
+        }
+
+        return EqualStage(left, right, parameters);
+    }
+
+    TokenAvaiableData BoolNotEqualStage(const TokenAvaiableData& left, const TokenAvaiableData& right, const Parameters& parameters) {
+        if (IsBool(left) && IsBool(right)) {
+            return left.get<bool>() != right.get<bool>();
+        }
 
-        auto ret = std::bind(func, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, function);
+        return NotEqualStage(left, right, parameters);
+    }
+
+    /*
+        Returns the operator specialized for [symbol] with operands of the given types, or nullptr if there is none.
+        String comparisons are left to the generic operators, which already test for strings first.
+    */
+    EvaluationOperator FindSpecializedStage(OperatorSymbol symbol, StageType left_type, StageType right_type) {
+        if (left_type != right_type) {
+            return nullptr;
+        }
 
-        return ret;
+        switch (left_type) {
+            case StageType::NUMERIC:
+                switch (symbol) {
+                    case OperatorSymbol::PLUS: return NumericAddStage;
+                    case OperatorSymbol::GTE: return NumericGteStage;
+                    case OperatorSymbol::GT: return NumericGtStage;
+                    case OperatorSymbol::LTE: return NumericLteStage;
+                    case OperatorSymbol::LT: return NumericLtStage;
+                    case OperatorSymbol::EQ: return NumericEqualStage;
+                    case OperatorSymbol::NEQ: return NumericNotEqualStage;
+                    default: return nullptr;
+                }
+            case StageType::STRING:
+                switch (symbol) {
+                    case OperatorSymbol::PLUS: return StringAddStage;
+                    case OperatorSymbol::EQ: return StringEqualStage;
+                    case OperatorSymbol::NEQ: return StringNotEqualStage;
+                    default: return nullptr;
+                }
+            case StageType::BOOLEAN:
+                switch (symbol) {
+                    case OperatorSymbol::EQ: return BoolEqualStage;
+                    case OperatorSymbol::NEQ: return BoolNotEqualStage;
+                    default: return nullptr;
+                }
+            default:
+                return nullptr;
+        }
     }
 
-    EvaluationOperator MakeAccessorStage(TokenAvaiableData value) {
-        auto func = [] (TokenAvaiableData, TokenAvaiableData, Parameters parameters, TokenAvaiableData& data) -> TokenAvaiableData {
-            if (data.empty()) {
-                throw CvaluateException("Cant' find varibale name in given strings");
+    EvaluationOperator MakeParameterStage(const std::string& parameter_name) {
+        return [parameter_name] (const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& parameters) -> TokenAvaiableData {
+            auto parameter = parameters.find(parameter_name);
+
+            if (parameter == parameters.end()) {
+                throw CvaluateException("Cant' find varibale name in parameter");
             }
 
-            std::vector<std::string> name_strings = data;
-            
-            auto variable_name = name_strings[0];
+            return parameter->second;
+        };
+    }
 
-            if (parameters.find(variable_name) == parameters.end()) {
+    EvaluationOperator MakeLiteralStage(const TokenAvaiableData& value) {
+        return [value] (const TokenAvaiableData&, const TokenAvaiableData&, const Parameters&) -> TokenAvaiableData {
+            return value;
+        };
+    }
+
+    EvaluationOperator MakeFunctionStage(const ExpressionFunction& function) {
+        return [function] (const TokenAvaiableData&, const TokenAvaiableData& right, const Parameters&) -> TokenAvaiableData {
+            return function(right);
+        };
+    }
+
+    EvaluationOperator MakeAccessorStage(const TokenAvaiableData& names) {
+        AccessorPath path(names);
+
+        return [path] (const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& parameters) -> TokenAvaiableData {
+            auto parameter = parameters.find(path.Root());
+
+            if (parameter == parameters.end()) {
                 throw CvaluateException("Cant' find varibale name in parameters");
             }
 
-            nlohmann::json j = parameters[variable_name];
+            return path.Resolve(parameter->second);
+        };
+    }
 
-            for (size_t i = 1; i < name_strings.size(); i++) {
-                auto field_name = name_strings[i];
-                j = j[field_name];
-            }
+    EvaluationOperator MakeRegexStage(const std::string& pattern, bool negate) {
+        auto regex = RegexCache::Default().Get(pattern);
 
-            return j;
+        return [regex, negate] (const TokenAvaiableData& left, const TokenAvaiableData&, const Parameters&) -> TokenAvaiableData {
+            return SearchRegex(left, *regex) != negate;
         };
+    }
 
-        auto ret = std::bind(func, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, value);
+    EvaluationOperator MakeMembershipStage(const TokenAvaiableData& elements) {
+        auto set = std::make_shared<const MembershipSet>(elements);
 
-        return ret;
+        return [set] (const TokenAvaiableData& left, const TokenAvaiableData&, const Parameters&) -> TokenAvaiableData {
+            return set->Contains(left);
+        };
     }
 
-    bool IsString(TokenAvaiableData& value) {
+    bool IsString(const TokenAvaiableData& value) {
         return value.is_string();
     }
 
-    bool IsBool(TokenAvaiableData& value) {
+    bool IsBool(const TokenAvaiableData& value) {
         return value.is_boolean();
     }
 
-    bool IsNumeric(TokenAvaiableData& value) {
+    bool IsNumeric(const TokenAvaiableData& value) {
         return IsFloat(value) || IsInt(value);
     }
 
-    bool IsFloat(TokenAvaiableData& value) {
+    bool IsFloat(const TokenAvaiableData& value) {
         return value.is_number_float();
     }
 
-    bool IsInt(TokenAvaiableData& value) {
+    bool IsInt(const TokenAvaiableData& value) {
         return value.is_number_integer();
     }
 
-    bool IsArray(TokenAvaiableData& value) {
-        return value.is_object();
+    bool IsArray(const TokenAvaiableData& value) {
+        return value.is_array();
     }
 
-    bool AdditionTypeCheck(TokenAvaiableData& left, TokenAvaiableData& right) {
+    bool AdditionTypeCheck(const TokenAvaiableData& left, const TokenAvaiableData& right) {
         if (IsNumeric(left) && IsNumeric(right)) {
             return true;
         }
@@ -280,7 +442,7 @@ namespace Cvaluate {
         return true;
     }
 
-    bool ComparatorTypeCheck(TokenAvaiableData& left, TokenAvaiableData& right) {
+    bool ComparatorTypeCheck(const TokenAvaiableData& left, const TokenAvaiableData& right) {
         if (IsNumeric(left) && IsNumeric(right)) {
             return true;
         }
@@ -293,10 +455,59 @@ namespace Cvaluate {
     }
 
 
-    bool IsRegexOrString(TokenAvaiableData& value) {
+    bool IsRegexOrString(const TokenAvaiableData& value) {
         return IsString(value);
     }
 
+    /*
+        Decides the result of a short-circuitable stage from its left value alone.
+        Returns true and sets [result] when the right stage doesn't need to be evaluated.
+    */
+    bool ShortCircuitStage(OperatorSymbol symbol, const TokenAvaiableData& left, TokenAvaiableData& result) {
+        switch (symbol) {
+            case OperatorSymbol::AND:
+                if (left.is_boolean() && !left.get<bool>()) {
+                    result = false;
+                    return true;
+                }
+                return false;
+            case OperatorSymbol::OR:
+                if (left.is_boolean() && left.get<bool>()) {
+                    result = true;
+                    return true;
+                }
+                return false;
+            case OperatorSymbol::TERNARY_TRUE:
+                if (left.is_boolean() && !left.get<bool>()) {
+                    result = nullptr;
+                    return true;
+                }
+                return false;
+            case OperatorSymbol::TERNARY_FALSE:
+            case OperatorSymbol::COALESCE:
+                if (!left.is_null()) {
+                    result = left;
+                    return true;
+                }
+                return false;
+            default:
+                return false;
+        }
+    }
+
+    bool EvaluationStage::IsShortCircuitable() const {
+        switch (this->symbol_) {
+            case OperatorSymbol::AND:
+            case OperatorSymbol::OR:
+            case OperatorSymbol::TERNARY_TRUE:
+            case OperatorSymbol::TERNARY_FALSE:
+            case OperatorSymbol::COALESCE:
+                return true;
+            default:
+                return false;
+        }
+    }
+
     void EvaluationStage::SwapWith(std::shared_ptr<EvaluationStage> other) {
         auto temp = *other;
         other->SetToNonStage(*this);
@@ -309,5 +520,117 @@ namespace Cvaluate {
         this->left_type_check_ = other.left_type_check_;
         this->right_type_check_ = other.right_type_check_;
         this->type_check_ = other.type_check_;
+        this->value_ = other.value_;
+        this->function_ = other.function_;
+        this->variadic_function_ = other.variadic_function_;
+        this->type_ = other.type_;
+    }
+
+    /*
+        Planning keeps the separators between the arguments of a call, so `f(a, b, c)` has the arguments
+        `SEPARATE(SEPARATE(a, b), c)` and `f()` a NOOP without operand.
+    */
+    static bool HasNoArguments(const EvaluationStage* arguments) {
+        return arguments == nullptr || (arguments->symbol_ == OperatorSymbol::NOOP && arguments->right_stage_ == nullptr);
+    }
+
+    std::vector<std::shared_ptr<EvaluationStage>> FindArgumentStages(const std::shared_ptr<EvaluationStage>& arguments) {
+        if (HasNoArguments(arguments.get())) {
+            return {};
+        }
+
+        if (arguments->symbol_ != OperatorSymbol::SEPARATE) {
+            return {arguments};
+        }
+
+        auto stages = FindArgumentStages(arguments->left_stage_);
+        stages.push_back(arguments->right_stage_);
+        return stages;
+    }
+
+    static size_t CountArguments(const EvaluationStage* arguments) {
+        if (HasNoArguments(arguments)) {
+            return 0;
+        }
+
+        if (arguments->symbol_ != OperatorSymbol::SEPARATE) {
+            return 1;
+        }
+
+        return CountArguments(arguments->left_stage_.get()) + 1;
+    }
+
+    // Evaluate the arguments in order into [values], returning how many were written.
+    static size_t EvaluateArguments(const EvaluationStage* arguments, TokenAvaiableData* values, const Parameters& params,
+            SharedStageResults& shared) {
+        if (arguments->symbol_ != OperatorSymbol::SEPARATE) {
+            values[0] = EvaluateStageTree(arguments, params, shared);
+            return 1;
+        }
+
+        auto count = EvaluateArguments(arguments->left_stage_.get(), values, params, shared);
+        values[count] = EvaluateStageTree(arguments->right_stage_.get(), params, shared);
+        return count + 1;
+    }
+
+    static TokenAvaiableData ApplyFunctionStage(const EvaluationStage* stage, const Parameters& params, SharedStageResults& shared) {
+        auto count = CountArguments(stage->right_stage_.get());
+        ArgumentBuffer<TokenAvaiableData> values(count);
+        ArgumentBuffer<const TokenAvaiableData*> arguments(count);
+
+        if (count > 0) {
+            EvaluateArguments(stage->right_stage_.get(), values.Data(), params, shared);
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            arguments.Data()[i] = &values.Data()[i];
+        }
+
+        return stage->variadic_function_(FunctionArguments(arguments.Data(), count));
+    }
+
+    static TokenAvaiableData ApplyStage(const EvaluationStage* stage, const Parameters& params, SharedStageResults& shared) {
+        TokenAvaiableData left, right;
+
+        if (stage->symbol_ == OperatorSymbol::FUNCTIONAL) {
+            return ApplyFunctionStage(stage, params, shared);
+        }
+
+        if (stage->left_stage_) {
+            left = EvaluateStageTree(stage->left_stage_.get(), params, shared);
+        }
+
+        // skip the right stage when the left value already decides the result.
+        if (stage->IsShortCircuitable() && ShortCircuitStage(stage->symbol_, left, right)) {
+            return right;
+        }
+
+        if (stage->right_stage_) {
+            right = EvaluateStageTree(stage->right_stage_.get(), params, shared);
+        }
+
+        return stage->operator_(left, right, params);
+    }
+
+    /*
+        Walks the tree through raw pointers: copying the shared_ptrs of the stages would make
+        every evaluating thread write to the same reference counts.
+        Shared stages are evaluated by the first parent reaching them, the other parents reuse the kept result.
+    */
+    TokenAvaiableData EvaluateStageTree(const EvaluationStage* stage, const Parameters& params, SharedStageResults& shared) {
+        if (stage == nullptr) {
+            throw CvaluateException("Found empty stage.");
+        }
+
+        if (stage->shared_index_ < 0) {
+            return ApplyStage(stage, params, shared);
+        }
+
+        auto& result = shared[stage->shared_index_];
+        if (!result) {
+            result = ApplyStage(stage, params, shared);
+        }
+
+        return *result;
     }
 } // Cvaluate
\ No newline at end of file
@@ -0,0 +1,79 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <cvaluate/ExpressionCache.h>
+#include <cvaluate/Exception.h>
+
+namespace Cvaluate {
+    std::string NormalizeExpression(const std::string& expression) {
+        std::string ret;
+        bool pending_space = false;
+        ret.reserve(expression.size());
+
+        for (size_t i = 0; i < expression.size(); i++) {
+            auto character = expression[i];
+
+            if (std::isspace(static_cast<unsigned char>(character))) {
+                pending_space = !ret.empty();
+                continue;
+            }
+
+            if (pending_space) {
+                ret += ' ';
+                pending_space = false;
+            }
+
+            ret += character;
+
+            // copy string literals and escaped names as they are, they end the same way the parser ends them.
+            if (character == '\'' || character == '"' || character == '[') {
+                for (i++; i < expression.size(); i++) {
+                    ret += expression[i];
+
+                    if (expression[i] == '\\' && i + 1 < expression.size()) {
+                        ret += expression[++i];
+                    } else if (character == '[' ? expression[i] == ']' : (expression[i] == '\'' || expression[i] == '"')) {
+                        break;
+                    }
+                }
+            }
+        }
+
+        return ret;
+    }
+
+    ExpressionCache::ExpressionCache(size_t capacity, size_t shards, EvaluationMode mode) :
+        cache_(capacity, shards), mode_(mode) {};
+
+    std::shared_ptr<const EvaluableExpression> ExpressionCache::Get(const std::string& expression, const FunctionSet& functions) {
+        Key key{NormalizeExpression(expression), functions.get()};
+
+        return this->cache_.GetOrCreate(key, [this, &key, &functions] {
+            auto compiled = std::make_shared<EvaluableExpression>(key.expression,
+                functions == nullptr ? ExpressionFunctionMap() : *functions);
+            compiled->SetEvaluationMode(this->mode_);
+
+            return CachedExpression{functions, compiled};
+        }).expression;
+    }
+
+    ExpressionCacheStatistics ExpressionCache::Statistics() const {
+        return this->cache_.Statistics();
+    }
+
+    void ExpressionCache::Clear() {
+        this->cache_.Clear();
+    }
+} // Cvaluate
@@ -0,0 +1,82 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <cvaluate/ExpressionSet.h>
+#include <cvaluate/Exception.h>
+
+namespace Cvaluate {
+    /*
+        Each expression is planned on its own first, so its own passes see a tree,
+        then the planned expressions are merged together and their shared stages numbered again.
+    */
+    ExpressionSet::ExpressionSet(const std::vector<std::string>& expressions, const ExpressionFunctionMap& functions,
+            const ParameterSchema& schema) : inputs_(expressions) {
+        for (auto& expression: expressions) {
+            auto tokens = ParseTokens(expression, functions);
+            PlanStatistics statistics;
+            auto stage = PlanStages(tokens, &statistics, schema);
+
+            if (stage == nullptr) {
+                throw CvaluateException("Found empty stage.");
+            }
+
+            this->stages_.push_back(stage);
+            this->eliminated_stages_ += statistics.eliminated_stages;
+        }
+
+        this->eliminated_stages_ += EliminateCommonStages(this->stages_);
+        this->shared_stages_ = NumberSharedStages(this->stages_);
+    }
+
+    size_t ExpressionSet::Size() const {
+        return this->stages_.size();
+    }
+
+    const std::string& ExpressionSet::Expression(size_t index) const {
+        return this->inputs_.at(index);
+    }
+
+    size_t ExpressionSet::EliminatedStages() const {
+        return this->eliminated_stages_;
+    }
+
+    std::vector<TokenAvaiableData> ExpressionSet::Evaluate(const Parameters& parameters) const {
+        std::vector<TokenAvaiableData> results;
+        results.reserve(this->stages_.size());
+        SharedStageResults shared(this->shared_stages_);
+
+        for (auto& stage: this->stages_) {
+            results.push_back(EvaluateStageTree(stage.get(), parameters, shared));
+        }
+
+        return results;
+    }
+
+    std::vector<TokenAvaiableData> ExpressionSet::Evaluate(const Parameters& parameters, const std::vector<size_t>& indices) const {
+        std::vector<TokenAvaiableData> results;
+        results.reserve(indices.size());
+        SharedStageResults shared(this->shared_stages_);
+
+        for (auto index: indices) {
+            if (index >= this->stages_.size()) {
+                throw CvaluateException("Expression index out of range");
+            }
+
+            results.push_back(EvaluateStageTree(this->stages_[index].get(), parameters, shared));
+        }
+
+        return results;
+    }
+} // Cvaluate
@@ -0,0 +1,248 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <cvaluate/MatchNetwork.h>
+#include <cvaluate/Exception.h>
+
+namespace Cvaluate {
+    static std::vector<std::string> SplitPath(const std::string& path) {
+        std::vector<std::string> names;
+        size_t begin = 0;
+
+        while (true) {
+            auto end = path.find('.', begin);
+            names.push_back(path.substr(begin, end - begin));
+
+            if (end == std::string::npos) {
+                break;
+            }
+            begin = end + 1;
+        }
+
+        return names;
+    }
+
+    /*
+        Every stage but the literals is numbered, so `EvaluateStageTree` keeps its result in `kept_`.
+    */
+    static void NumberStage(EvaluationStage* stage, int parent, std::unordered_map<const EvaluationStage*, int>& numbers,
+            std::vector<std::vector<int>>& parents, std::map<std::string, std::vector<int>>& readers) {
+        if (stage->symbol_ == OperatorSymbol::LITERAL) {
+            return;
+        }
+
+        auto number = numbers.find(stage);
+        if (number != numbers.end()) {
+            if (parent >= 0) {
+                parents[number->second].push_back(parent);
+            }
+            return;
+        }
+
+        auto index = static_cast<int>(parents.size());
+        numbers.emplace(stage, index);
+        stage->shared_index_ = index;
+        parents.emplace_back();
+        if (parent >= 0) {
+            parents[index].push_back(parent);
+        }
+
+        if (stage->symbol_ == OperatorSymbol::VALUE) {
+            readers[stage->value_.get<std::string>()].push_back(index);
+        } else if (stage->symbol_ == OperatorSymbol::ACCESS) {
+            std::string path;
+            for (auto& name: stage->value_) {
+                path += (path.empty() ? "" : ".") + name.get<std::string>();
+            }
+            readers[path].push_back(index);
+        }
+
+        // calls evaluate their arguments directly, the separators between them never keep a result.
+        if (stage->symbol_ == OperatorSymbol::FUNCTIONAL) {
+            for (auto& argument: FindArgumentStages(stage->right_stage_)) {
+                NumberStage(argument.get(), index, numbers, parents, readers);
+            }
+            return;
+        }
+
+        for (auto child: {stage->left_stage_.get(), stage->right_stage_.get()}) {
+            if (child != nullptr) {
+                NumberStage(child, index, numbers, parents, readers);
+            }
+        }
+    }
+
+    MatchNetwork::MatchNetwork(const std::vector<std::string>& expressions, Parameters facts,
+            const ExpressionFunctionMap& functions, const ParameterSchema& schema) : facts_(std::move(facts)) {
+        for (auto& expression: expressions) {
+            auto tokens = ParseTokens(expression, functions);
+            auto stage = PlanStages(tokens, nullptr, schema);
+
+            if (stage == nullptr) {
+                throw CvaluateException("Found empty stage.");
+            }
+
+            this->stages_.push_back(stage);
+        }
+
+        EliminateCommonStages(this->stages_);
+
+        std::unordered_map<const EvaluationStage*, int> numbers;
+        for (auto& stage: this->stages_) {
+            NumberStage(stage.get(), -1, numbers, this->parents_, this->readers_);
+        }
+
+        this->kept_.resize(this->parents_.size());
+        this->results_.resize(this->stages_.size());
+
+        // literal expressions are never evaluated again.
+        for (size_t i = 0; i < this->stages_.size(); i++) {
+            if (this->stages_[i]->shared_index_ < 0) {
+                this->results_[i] = this->stages_[i]->value_;
+            }
+        }
+
+        this->Propagate();
+    }
+
+    size_t MatchNetwork::Size() const {
+        return this->stages_.size();
+    }
+
+    const std::vector<TokenAvaiableData>& MatchNetwork::Results() const {
+        return this->results_;
+    }
+
+    const Parameters& MatchNetwork::Facts() const {
+        return this->facts_;
+    }
+
+    /*
+        A stage without a kept result has no parent relying on it: either its parents are already invalidated,
+        or they were decided without it, like `false && stage`. So invalidating stops there.
+    */
+    void MatchNetwork::Invalidate(int stage) {
+        if (!this->kept_[stage]) {
+            return;
+        }
+
+        this->kept_[stage].reset();
+        for (auto parent: this->parents_[stage]) {
+            this->Invalidate(parent);
+        }
+    }
+
+    /*
+        Changing `r.env` changes what `r`, `r.env` and `r.env.hour` read, but not `r.sub`.
+    */
+    void MatchNetwork::Invalidate(const std::string& path) {
+        for (auto end = path.find('.'); ; end = path.find('.', end + 1)) {
+            auto readers = this->readers_.find(path.substr(0, end));
+            if (readers != this->readers_.end()) {
+                for (auto stage: readers->second) {
+                    this->Invalidate(stage);
+                }
+            }
+
+            if (end == std::string::npos) {
+                break;
+            }
+        }
+
+        auto prefix = path + ".";
+        for (auto readers = this->readers_.lower_bound(prefix); readers != this->readers_.end(); ++readers) {
+            if (readers->first.compare(0, prefix.size(), prefix) != 0) {
+                break;
+            }
+
+            for (auto stage: readers->second) {
+                this->Invalidate(stage);
+            }
+        }
+    }
+
+    std::vector<MatchNetwork::MatchChange> MatchNetwork::Propagate() {
+        std::vector<MatchChange> changes;
+
+        for (size_t i = 0; i < this->stages_.size(); i++) {
+            auto stage = this->stages_[i].get();
+            if (stage->shared_index_ < 0 || this->kept_[stage->shared_index_]) {
+                continue;
+            }
+
+            TokenAvaiableData result;
+            try {
+                result = EvaluateStageTree(stage, this->facts_, this->kept_);
+            } catch (const CvaluateException&) {
+                result = nullptr;
+            }
+
+            if (result != this->results_[i]) {
+                changes.push_back({i, std::move(this->results_[i]), result});
+                this->results_[i] = std::move(result);
+            }
+        }
+
+        return changes;
+    }
+
+    std::vector<MatchNetwork::MatchChange> MatchNetwork::Update(const std::string& path, TokenAvaiableData value) {
+        auto names = SplitPath(path);
+        auto fact = &this->facts_[names[0]];
+
+        for (size_t i = 1; i < names.size(); i++) {
+            if (fact->is_null()) {
+                *fact = TokenAvaiableData::object();
+            }
+
+            if (!fact->is_object()) {
+                throw CvaluateException("Unable to set field '" + names[i] + "' of a non-object value");
+            }
+
+            fact = &(*fact)[names[i]];
+        }
+
+        *fact = std::move(value);
+        this->Invalidate(path);
+        return this->Propagate();
+    }
+
+    std::vector<MatchNetwork::MatchChange> MatchNetwork::Retract(const std::string& path) {
+        auto names = SplitPath(path);
+        auto variable = this->facts_.find(names[0]);
+        if (variable == this->facts_.end()) {
+            return {};
+        }
+
+        if (names.size() == 1) {
+            this->facts_.erase(variable);
+        } else {
+            auto fact = &variable->second;
+            for (size_t i = 1; i + 1 < names.size(); i++) {
+                if (!fact->is_object() || !fact->contains(names[i])) {
+                    return {};
+                }
+                fact = &(*fact)[names[i]];
+            }
+
+            if (!fact->is_object() || fact->erase(names.back()) == 0) {
+                return {};
+            }
+        }
+
+        this->Invalidate(path);
+        return this->Propagate();
+    }
+} // Cvaluate
@@ -0,0 +1,94 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <cvaluate/MembershipSet.h>
+#include <cvaluate/Exception.h>
+
+#include <algorithm>
+
+namespace Cvaluate {
+    MembershipSet::MembershipSet(const TokenAvaiableData& elements) {
+        if (!elements.is_array()) {
+            throw CvaluateException("Value of 'in' must be an array");
+        }
+
+        std::vector<std::string> strings;
+
+        for (auto& element: elements) {
+            if (element.is_string()) {
+                strings.push_back(element.get<std::string>());
+            } else if (element.is_number()) {
+                // adding zero turns -0 into 0, they are equal.
+                this->numbers_.push_back(GetTokenValueNumeric(element) + 0.0f);
+            } else if (element.is_boolean()) {
+                (element.get<bool>() ? this->has_true_ : this->has_false_) = true;
+            } else if (element.is_null()) {
+                this->has_null_ = true;
+            } else {
+                this->others_.push_back(element);
+            }
+        }
+
+        this->size_ = elements.size();
+
+        if (strings.size() > kScanLimit) {
+            this->hashed_strings_.insert(strings.begin(), strings.end());
+        } else {
+            this->strings_ = std::move(strings);
+        }
+
+        if (this->numbers_.size() > kScanLimit) {
+            std::sort(this->numbers_.begin(), this->numbers_.end());
+            this->sorted_numbers_ = true;
+        }
+    }
+
+    bool MembershipSet::Contains(const TokenAvaiableData& value) const {
+        switch (value.type()) {
+            case nlohmann::json::value_t::string: {
+                auto& string = value.get_ref<const std::string&>();
+
+                if (!this->hashed_strings_.empty()) {
+                    return this->hashed_strings_.count(string) != 0;
+                }
+
+                return std::find(this->strings_.begin(), this->strings_.end(), string) != this->strings_.end();
+            }
+            case nlohmann::json::value_t::number_integer:
+            case nlohmann::json::value_t::number_unsigned:
+            case nlohmann::json::value_t::number_float: {
+                // `==` compares numbers as floats, so must the set.
+                float number = GetTokenValueNumeric(value) + 0.0f;
+
+                if (this->sorted_numbers_) {
+                    return std::binary_search(this->numbers_.begin(), this->numbers_.end(), number);
+                }
+
+                bool found = false;
+                // no early exit, so the scan vectorizes.
+                for (auto element: this->numbers_) {
+                    found |= element == number;
+                }
+                return found;
+            }
+            case nlohmann::json::value_t::boolean:
+                return value.get<bool>() ? this->has_true_ : this->has_false_;
+            case nlohmann::json::value_t::null:
+                return this->has_null_;
+            default:
+                return std::find(this->others_.begin(), this->others_.end(), value) != this->others_.end();
+        }
+    }
+} // Cvaluate
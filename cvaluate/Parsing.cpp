@@ -18,7 +18,7 @@
 #include <cvaluate/Exception.h>
 
 namespace Cvaluate {
-    std::vector<ExpressionToken> ParseTokens(std::string& expression, ExpressionFunctionMap& functions) {
+    std::vector<ExpressionToken> ParseTokens(const std::string& expression, const ExpressionFunctionMap& functions) {
         std::stringstream stream(expression);
         std::vector<ExpressionToken> ret;
         // Parse state machine
@@ -33,6 +33,16 @@ namespace Cvaluate {
                 break;
             }
 
+            // a string right of a regex comparator is a pattern, or its start when it is concatenated;
+            // the planner compiles the whole literal pattern.
+            if (token.Kind == TokenKind::STRING && !ret.empty() && ret.back().Kind == TokenKind::COMPARATOR) {
+                auto comparator = GetTokenValueString(ret.back().Value);
+
+                if (comparator == "=~" || comparator == "!~") {
+                    token.Kind = TokenKind::PATTERN;
+                }
+            }
+
             // Get Possible State
             if (!GetPossibleStateForToken(state, token.Kind)) {
                 return ret;
@@ -142,7 +152,7 @@ namespace Cvaluate {
                 // is function
                 if (functions.find(token_string) != functions.end()) {
                     kind = TokenKind::FUNCTION;
-                    token_value = functions[token_string];
+                    token_value = functions.at(token_string);
                 }
 
                 // accessor
@@ -0,0 +1,306 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <cvaluate/RangeIndex.h>
+#include <cvaluate/Exception.h>
+
+#include <limits>
+
+namespace Cvaluate {
+    static constexpr float kInfinity = std::numeric_limits<float>::infinity();
+
+    // Return the name of a variable or accessor chain like "r.amount", or an empty string for other stages.
+    static std::string FindVariableName(const EvaluationStage* stage) {
+        if (stage == nullptr) {
+            return "";
+        }
+
+        if (stage->symbol_ == OperatorSymbol::VALUE) {
+            return stage->value_.get<std::string>();
+        }
+
+        if (stage->symbol_ != OperatorSymbol::ACCESS) {
+            return "";
+        }
+
+        std::string name;
+        for (auto& field: stage->value_) {
+            name += (name.empty() ? "" : ".") + field.get<std::string>();
+        }
+        return name;
+    }
+
+    static bool IsNumericLiteral(const EvaluationStage* stage) {
+        return stage != nullptr && stage->symbol_ == OperatorSymbol::LITERAL && IsNumeric(stage->value_);
+    }
+
+    struct VariableBounds {
+        std::string name;
+        const EvaluationStage* variable;
+        float low = -kInfinity;
+        bool low_strict = false;
+        float high = kInfinity;
+        bool high_strict = false;
+    };
+
+    // Narrows the bounds of a rule by the comparisons of a variable with a numeric literal in its top-level conjunction.
+    static void AddBounds(const EvaluationStage* stage, std::vector<VariableBounds>& bounds) {
+        if (stage->symbol_ == OperatorSymbol::AND) {
+            AddBounds(stage->left_stage_.get(), bounds);
+            AddBounds(stage->right_stage_.get(), bounds);
+            return;
+        }
+
+        auto symbol = stage->symbol_;
+        auto variable = stage->left_stage_.get();
+        auto literal = stage->right_stage_.get();
+
+        // `1000 < r.amount` bounds the variable like `r.amount > 1000`.
+        if (IsNumericLiteral(variable)) {
+            std::swap(variable, literal);
+            switch (symbol) {
+                case OperatorSymbol::GT: symbol = OperatorSymbol::LT; break;
+                case OperatorSymbol::GTE: symbol = OperatorSymbol::LTE; break;
+                case OperatorSymbol::LT: symbol = OperatorSymbol::GT; break;
+                case OperatorSymbol::LTE: symbol = OperatorSymbol::GTE; break;
+                default: break;
+            }
+        }
+
+        bool lower = symbol == OperatorSymbol::GT || symbol == OperatorSymbol::GTE;
+        bool upper = symbol == OperatorSymbol::LT || symbol == OperatorSymbol::LTE;
+        auto name = FindVariableName(variable);
+
+        if ((!lower && !upper) || name.empty() || !IsNumericLiteral(literal)) {
+            return;
+        }
+
+        auto bound = std::find_if(bounds.begin(), bounds.end(), [&name](const VariableBounds& bound) {
+            return bound.name == name;
+        });
+
+        if (bound == bounds.end()) {
+            bounds.push_back({name, variable});
+            bound = bounds.end() - 1;
+        }
+
+        // compared as float, like the comparison stages do.
+        auto value = GetTokenValueNumeric(literal->value_);
+        bool strict = symbol == OperatorSymbol::GT || symbol == OperatorSymbol::LT;
+
+        if (lower && (value > bound->low || (value == bound->low && strict))) {
+            bound->low = value;
+            bound->low_strict = strict;
+        }
+
+        if (upper && (value < bound->high || (value == bound->high && strict))) {
+            bound->high = value;
+            bound->high_strict = strict;
+        }
+    }
+
+    /*
+        Each rule is indexed by one variable: the first one bounded on both sides, or else the first one bounded.
+        Rules whose bounds no value can meet are never candidates.
+    */
+    RangeIndex::RangeIndex(std::vector<std::shared_ptr<const EvaluableExpression>> rules) : rules_(std::move(rules)) {
+        std::unordered_map<std::string, size_t> variable_names;
+        std::vector<std::vector<Interval>> intervals;
+
+        for (size_t rule = 0; rule < this->rules_.size(); rule++) {
+            if (this->rules_[rule] == nullptr) {
+                throw CvaluateException("Found empty expression.");
+            }
+
+            std::vector<VariableBounds> bounds;
+            AddBounds(this->rules_[rule]->Stages(), bounds);
+
+            if (bounds.empty()) {
+                this->unindexed_rules_.push_back(rule);
+                continue;
+            }
+
+            auto bound = std::find_if(bounds.begin(), bounds.end(), [](const VariableBounds& bound) {
+                return bound.low != -kInfinity && bound.high != kInfinity;
+            });
+            if (bound == bounds.end()) {
+                bound = bounds.begin();
+            }
+
+            auto variable = variable_names.emplace(bound->name, this->variables_.size());
+            if (variable.second) {
+                auto& names = bound->variable->value_;
+                this->variables_.push_back({AccessorPath(names.is_array() ? names : TokenAvaiableData::array({names})), {}, -1, {}});
+                intervals.emplace_back();
+            }
+
+            this->variables_[variable.first->second].rules.push_back(rule);
+
+            Interval interval{bound->low, bound->low_strict, bound->high, bound->high_strict, rule};
+            if (interval.low < interval.high || (interval.low == interval.high && interval.AboveLow(interval.low) &&
+                    interval.BelowHigh(interval.high))) {
+                intervals[variable.first->second].push_back(interval);
+            }
+        }
+
+        for (size_t variable = 0; variable < this->variables_.size(); variable++) {
+            auto& indexed = this->variables_[variable];
+            indexed.root = BuildIntervalTree(indexed.nodes, std::move(intervals[variable]));
+        }
+    }
+
+    /*
+        The center of a node is the median of the finite bounds of its intervals, so both subtrees get at most
+        half of the intervals and the depth of the tree stays logarithmic.
+    */
+    int RangeIndex::BuildIntervalTree(std::vector<IntervalNode>& nodes, std::vector<Interval> intervals) {
+        if (intervals.empty()) {
+            return -1;
+        }
+
+        std::vector<float> bounds;
+        for (auto& interval: intervals) {
+            if (interval.low != -kInfinity) {
+                bounds.push_back(interval.low);
+            }
+            if (interval.high != kInfinity) {
+                bounds.push_back(interval.high);
+            }
+        }
+
+        float center = 0;
+        if (!bounds.empty()) {
+            std::nth_element(bounds.begin(), bounds.begin() + bounds.size() / 2, bounds.end());
+            center = bounds[bounds.size() / 2];
+        }
+
+        std::vector<Interval> below, above;
+        IntervalNode node;
+        node.center = center;
+
+        for (auto& interval: intervals) {
+            if (interval.high < center) {
+                below.push_back(interval);
+            } else if (interval.low > center) {
+                above.push_back(interval);
+            } else {
+                node.by_low.push_back(interval);
+            }
+        }
+
+        // among equal bounds, inclusive ones come first: they contain every value the strict ones contain.
+        node.by_high = node.by_low;
+        std::sort(node.by_low.begin(), node.by_low.end(), [](const Interval& left, const Interval& right) {
+            return left.low < right.low || (left.low == right.low && !left.low_strict && right.low_strict);
+        });
+        std::sort(node.by_high.begin(), node.by_high.end(), [](const Interval& left, const Interval& right) {
+            return left.high > right.high || (left.high == right.high && !left.high_strict && right.high_strict);
+        });
+
+        auto index = nodes.size();
+        nodes.push_back(std::move(node));
+
+        auto below_node = BuildIntervalTree(nodes, std::move(below));
+        auto above_node = BuildIntervalTree(nodes, std::move(above));
+        nodes[index].below = below_node;
+        nodes[index].above = above_node;
+
+        return index;
+    }
+
+    // Intervals of a node all contain its center, so only the bound on the side of [value] needs checking.
+    void RangeIndex::FindIntervals(const std::vector<IntervalNode>& nodes, int node, float value, std::vector<size_t>& rules) {
+        while (node >= 0) {
+            auto& current = nodes[node];
+
+            if (value < current.center) {
+                for (auto& interval: current.by_low) {
+                    if (!interval.AboveLow(value)) {
+                        break;
+                    }
+                    rules.push_back(interval.rule);
+                }
+                node = current.below;
+            } else if (value > current.center) {
+                for (auto& interval: current.by_high) {
+                    if (!interval.BelowHigh(value)) {
+                        break;
+                    }
+                    rules.push_back(interval.rule);
+                }
+                node = current.above;
+            } else {
+                for (auto& interval: current.by_low) {
+                    if (interval.AboveLow(value) && interval.BelowHigh(value)) {
+                        rules.push_back(interval.rule);
+                    }
+                }
+                return;
+            }
+        }
+    }
+
+    size_t RangeIndex::Size() const {
+        return this->rules_.size();
+    }
+
+    size_t RangeIndex::IndexedRules() const {
+        return this->rules_.size() - this->unindexed_rules_.size();
+    }
+
+    /*
+        A variable that is missing or isn't a number makes every rule it indexes a candidate,
+        so the error of its comparison is raised when they are evaluated.
+    */
+    std::vector<size_t> RangeIndex::Candidates(const Parameters& parameters) const {
+        std::vector<size_t> candidates = this->unindexed_rules_;
+
+        for (auto& variable: this->variables_) {
+            const TokenAvaiableData* value = nullptr;
+            auto root = parameters.find(variable.path.Root());
+
+            if (root != parameters.end()) {
+                try {
+                    value = &variable.path.Resolve(root->second);
+                } catch (const std::exception&) {
+                    value = nullptr;
+                }
+            }
+
+            if (value == nullptr || !IsNumeric(*value)) {
+                candidates.insert(candidates.end(), variable.rules.begin(), variable.rules.end());
+                continue;
+            }
+
+            FindIntervals(variable.nodes, variable.root, GetTokenValueNumeric(*value), candidates);
+        }
+
+        std::sort(candidates.begin(), candidates.end());
+
+        return candidates;
+    }
+
+    std::vector<size_t> RangeIndex::Match(const Parameters& parameters) const {
+        std::vector<size_t> matches;
+
+        for (auto rule: this->Candidates(parameters)) {
+            if (GetTokenValueBool(this->rules_[rule]->Evaluate(parameters))) {
+                matches.push_back(rule);
+            }
+        }
+
+        return matches;
+    }
+} // Cvaluate
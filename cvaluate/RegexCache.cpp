@@ -0,0 +1,33 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <cvaluate/RegexCache.h>
+
+namespace Cvaluate {
+    std::shared_ptr<const std::regex> RegexCache::Get(const std::string& pattern) {
+        return this->cache_.GetOrCreate(pattern, [&pattern] {
+            try {
+                return std::make_shared<const std::regex>(pattern);
+            } catch (const std::regex_error& error) {
+                throw CvaluateException("Unable to compile regex '" + pattern + "': " + error.what());
+            }
+        });
+    }
+
+    RegexCache& RegexCache::Default() {
+        static RegexCache cache;
+        return cache;
+    }
+} // Cvaluate
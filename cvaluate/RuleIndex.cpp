@@ -0,0 +1,195 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <cvaluate/RuleIndex.h>
+#include <cvaluate/Exception.h>
+
+namespace Cvaluate {
+    /*
+        Key of a value under `==`: scalars equal under `==` have the same key, numbers being compared as float.
+        Returns false for arrays and objects.
+    */
+    static bool FindEqualityKey(const TokenAvaiableData& value, std::string& key) {
+        switch (value.type()) {
+            case nlohmann::json::value_t::string:
+                key = "s" + value.get_ref<const std::string&>();
+                return true;
+            case nlohmann::json::value_t::number_integer:
+            case nlohmann::json::value_t::number_unsigned:
+            case nlohmann::json::value_t::number_float: {
+                // adding zero turns -0 into 0, they are equal.
+                float number = GetTokenValueNumeric(value) + 0.0f;
+                key = "n" + std::string(reinterpret_cast<const char*>(&number), sizeof(number));
+                return true;
+            }
+            case nlohmann::json::value_t::boolean:
+                key = value.get<bool>() ? "t" : "f";
+                return true;
+            case nlohmann::json::value_t::null:
+                key = "0";
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    static bool IsRowField(const EvaluationStage* stage, const std::string& row_name) {
+        return stage->symbol_ == OperatorSymbol::ACCESS && stage->value_[0] == row_name;
+    }
+
+    // Keys may be any subtree that doesn't read the row and doesn't call a function that isn't pure.
+    static bool IsRowIndependent(const EvaluationStage* stage, const std::string& row_name) {
+        if (stage == nullptr) {
+            return true;
+        }
+
+        switch (stage->symbol_) {
+            case OperatorSymbol::VALUE:
+                return stage->value_ != row_name;
+            case OperatorSymbol::ACCESS:
+                return stage->value_[0] != row_name;
+            case OperatorSymbol::FUNCTIONAL:
+                if (FindPureFunction(stage->function_) == nullptr) {
+                    return false;
+                }
+                break;
+            default:
+                break;
+        }
+
+        return IsRowIndependent(stage->left_stage_.get(), row_name) && IsRowIndependent(stage->right_stage_.get(), row_name);
+    }
+
+    RuleIndex::RuleIndex(std::shared_ptr<const EvaluableExpression> expression, const std::string& row_name,
+            std::vector<TokenAvaiableData> rows) : expression_(expression), row_name_(row_name), rows_(std::move(rows)) {
+        if (this->expression_ == nullptr) {
+            throw CvaluateException("Found empty expression.");
+        }
+
+        this->row_slot_ = this->expression_->FindParameterSlot(row_name);
+        this->AddPredicates(this->expression_->Stages());
+
+        std::string key;
+
+        for (auto& predicate: this->predicates_) {
+            for (size_t row = 0; row < this->rows_.size(); row++) {
+                try {
+                    if (FindEqualityKey(predicate.row_field.Resolve(this->rows_[row]), key)) {
+                        predicate.rows[key].push_back(row);
+                        continue;
+                    }
+                } catch (const std::exception&) {
+                    // the field can't be resolved in this row, evaluating the row raises the error.
+                }
+
+                predicate.unindexed_rows.push_back(row);
+            }
+        }
+    }
+
+    // Collects the equality predicates of the top-level conjunction, a false one makes the whole expression false.
+    void RuleIndex::AddPredicates(const EvaluationStage* stage) {
+        if (stage->symbol_ == OperatorSymbol::AND) {
+            this->AddPredicates(stage->left_stage_.get());
+            this->AddPredicates(stage->right_stage_.get());
+            return;
+        }
+
+        if (stage->symbol_ != OperatorSymbol::EQ) {
+            return;
+        }
+
+        auto left = stage->left_stage_.get();
+        auto right = stage->right_stage_.get();
+
+        if (IsRowField(right, this->row_name_)) {
+            std::swap(left, right);
+        }
+
+        if (IsRowField(left, this->row_name_) && IsRowIndependent(right, this->row_name_)) {
+            this->predicates_.push_back({AccessorPath(left->value_), right, {}, {}});
+        }
+    }
+
+    size_t RuleIndex::Size() const {
+        return this->rows_.size();
+    }
+
+    size_t RuleIndex::IndexedPredicates() const {
+        return this->predicates_.size();
+    }
+
+    std::vector<size_t> RuleIndex::Candidates(const Parameters& parameters) const {
+        static const std::vector<size_t> kNoRows;
+        const std::vector<size_t>* best_rows = nullptr;
+        const std::vector<size_t>* best_unindexed_rows = nullptr;
+        SharedStageResults shared(this->expression_->Statistics().shared_stages);
+        std::string key;
+
+        for (auto& predicate: this->predicates_) {
+            try {
+                if (!FindEqualityKey(EvaluateStageTree(predicate.key, parameters, shared), key)) {
+                    continue;
+                }
+            } catch (const std::exception&) {
+                // without its key, the predicate can't narrow the rows down.
+                continue;
+            }
+
+            auto found = predicate.rows.find(key);
+            auto& rows = found == predicate.rows.end() ? kNoRows : found->second;
+
+            if (best_rows == nullptr || rows.size() + predicate.unindexed_rows.size() <
+                    best_rows->size() + best_unindexed_rows->size()) {
+                best_rows = &rows;
+                best_unindexed_rows = &predicate.unindexed_rows;
+            }
+        }
+
+        std::vector<size_t> candidates;
+
+        if (best_rows == nullptr) {
+            candidates.resize(this->rows_.size());
+            for (size_t row = 0; row < candidates.size(); row++) {
+                candidates[row] = row;
+            }
+            return candidates;
+        }
+
+        candidates.reserve(best_rows->size() + best_unindexed_rows->size());
+        std::merge(best_rows->begin(), best_rows->end(), best_unindexed_rows->begin(), best_unindexed_rows->end(),
+            std::back_inserter(candidates));
+
+        return candidates;
+    }
+
+    std::vector<size_t> RuleIndex::Match(const Parameters& parameters) const {
+        std::vector<size_t> matches;
+        auto frame = this->expression_->MakeParameterFrame();
+        BindParameters(frame, this->expression_->ParameterSlots(), parameters);
+
+        for (auto row: this->Candidates(parameters)) {
+            if (this->row_slot_ >= 0) {
+                frame.Bind(this->row_slot_, this->rows_[row]);
+            }
+
+            if (GetTokenValueBool(this->expression_->Evaluate(frame))) {
+                matches.push_back(row);
+            }
+        }
+
+        return matches;
+    }
+} // Cvaluate
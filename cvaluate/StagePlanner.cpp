@@ -17,7 +17,7 @@
 #include <cvaluate/Exception.h>
 
 namespace Cvaluate {
-    std::unordered_map<OperatorSymbol, EvaluationOperator> kStageSymbolMap = {
+    const static std::unordered_map<OperatorSymbol, EvaluationOperator> kStageSymbolMap = {
         {OperatorSymbol::EQ, EqualStage},
         {OperatorSymbol::NEQ, NotEqualStage},
         {OperatorSymbol::GT, GtStage},
@@ -56,33 +56,57 @@ namespace Cvaluate {
     const static std::vector<TokenKind> kTernaryKind = {TokenKind::TERNARY};
     const static std::vector<TokenKind> kSeparatorKind = {TokenKind::SEPARATOR};
 
-    Precedent planFunctions = PlanFunctions;
-    PrecedencePlanner planPrefix(&kPrefixSymbols, &kPrefixKind, nullptr, planFunctions);
-    PrecedencePlanner planExponential(&kExponentialSymbolsS, &kModifierKind, planFunctions, nullptr);
-    PrecedencePlanner planMultiplicative(&kMultiplicativeSymbols, &kModifierKind, planExponential, nullptr);
-    PrecedencePlanner planAdditive(&kAdditiveSymbols, &kModifierKind, planMultiplicative, nullptr);
-    PrecedencePlanner planShift(&kBitwiseShiftSymbols, &kModifierKind, planAdditive, nullptr);
-    PrecedencePlanner planBitwise(&kBitwiseSymbols, &kModifierKind, planShift, nullptr);
-    PrecedencePlanner planComparator(&kComparatorSymbols, &kComparatorKind, planBitwise, nullptr);
-    PrecedencePlanner planLogicalAnd(&kLogicalAndSymbols, &kLogicalopKind, planComparator, nullptr);
-    PrecedencePlanner planLogicalOr(&kLogicalOrSymbols, &kLogicalopKind, planLogicalAnd, nullptr);
-    PrecedencePlanner planTernary(&kTernarySymbols, &kTernaryKind, planLogicalOr, nullptr);
-    PrecedencePlanner planSeparator(&kSeparatorSymbols, &kSeparatorKind, planTernary, nullptr);
+    const static Precedent planFunctions = PlanFunctions;
+    const static PrecedencePlanner planPrefix(&kPrefixSymbols, &kPrefixKind, nullptr, planFunctions);
+    const static PrecedencePlanner planExponential(&kExponentialSymbolsS, &kModifierKind, planFunctions, nullptr);
+    const static PrecedencePlanner planMultiplicative(&kMultiplicativeSymbols, &kModifierKind, planExponential, nullptr);
+    const static PrecedencePlanner planAdditive(&kAdditiveSymbols, &kModifierKind, planMultiplicative, nullptr);
+    const static PrecedencePlanner planShift(&kBitwiseShiftSymbols, &kModifierKind, planAdditive, nullptr);
+    const static PrecedencePlanner planBitwise(&kBitwiseSymbols, &kModifierKind, planShift, nullptr);
+    const static PrecedencePlanner planComparator(&kComparatorSymbols, &kComparatorKind, planBitwise, nullptr);
+    const static PrecedencePlanner planLogicalAnd(&kLogicalAndSymbols, &kLogicalopKind, planComparator, nullptr);
+    const static PrecedencePlanner planLogicalOr(&kLogicalOrSymbols, &kLogicalopKind, planLogicalAnd, nullptr);
+    const static PrecedencePlanner planTernary(&kTernarySymbols, &kTernaryKind, planLogicalOr, nullptr);
+    const static PrecedencePlanner planSeparator(&kSeparatorSymbols, &kSeparatorKind, planTernary, nullptr);
 
     /*
         Creates a `evaluationStageList` object which represents an execution plan (or tree)
         which is used to completely evaluate a set of tokens at evaluation-time.
         The three stages of evaluation can be thought of as parsing strings to tokens, then tokens to a stage list, then evaluation with parameters.
     */
-    std::shared_ptr<EvaluationStage> PlanStages(std::vector<ExpressionToken>& tokens) {
+    std::shared_ptr<EvaluationStage> PlanStages(std::vector<ExpressionToken>& tokens, PlanStatistics* statistics,
+            const ParameterSchema& schema) {
         TokenStream stream(tokens);
 
         auto stage = PlanTokens(stream);
+        if (stage == nullptr) {
+            return nullptr;
+        }
 
         // while we're now fully-planned, we now need to re-order same-precedence operators.
         // this could probably be avoided with a different planning method
         RecorderStages(stage);
 
+        // with the final order known, work that doesn't depend on parameters can be done once here.
+        auto folded_stages = FoldConstantStages(stage);
+
+        // type errors between literals and declared parameters are raised here instead of at evaluation-time.
+        auto specialized_stages = InferStageTypes(stage, schema);
+
+        // literal regex patterns and `in` lists are prepared once here, after their types are checked.
+        PrecompileLiteralOperands(stage);
+
+        // repeated subtrees are merged last, the passes above change stages in place and expect a tree.
+        auto eliminated_stages = EliminateCommonStages(stage);
+        auto shared_stages = NumberSharedStages(stage);
+
+        if (statistics != nullptr) {
+            statistics->folded_stages = folded_stages;
+            statistics->specialized_stages = specialized_stages;
+            statistics->eliminated_stages = eliminated_stages;
+            statistics->shared_stages = shared_stages;
+        }
+
         return stage;
     }
 
@@ -135,13 +159,438 @@ namespace Cvaluate {
         }
     }
 
+    static std::shared_ptr<EvaluationStage> MakeLiteralEvaluationStage(const TokenAvaiableData& value) {
+        auto ret = std::make_shared<EvaluationStage>(OperatorSymbol::LITERAL, nullptr, nullptr,
+            MakeLiteralStage(value), nullptr, nullptr, nullptr);
+        ret->value_ = value;
+
+        return ret;
+    }
+
+    static bool IsLiteralStage(const std::shared_ptr<EvaluationStage>& stage) {
+        return stage == nullptr || stage->symbol_ == OperatorSymbol::LITERAL;
+    }
+
+    /*
+        Folds each argument of a call on its own, keeping the separators between them,
+        so `f(1, 2)` is still called with two arguments instead of the array `[1, 2]`.
+    */
+    static size_t FoldArgumentStages(std::shared_ptr<EvaluationStage>& stage) {
+        if (stage == nullptr) {
+            return 0;
+        }
+
+        if (stage->symbol_ == OperatorSymbol::NOOP && stage->right_stage_ != nullptr) {
+            stage = stage->right_stage_;
+            return FoldArgumentStages(stage) + 1;
+        }
+
+        if (stage->symbol_ != OperatorSymbol::SEPARATE) {
+            return FoldConstantStages(stage);
+        }
+
+        return FoldArgumentStages(stage->left_stage_) + FoldConstantStages(stage->right_stage_);
+    }
+
+    /*
+        Replaces every subtree whose leaves are all literals by a single literal holding its value,
+        and removes the NOOP stages planned for clauses.
+        Short-circuitable stages with a deciding literal on the left are folded regardless of their right stage.
+        Subtrees that fail to evaluate are kept, so the error is still raised at evaluation-time.
+        Returns the number of stages removed.
+    */
+    size_t FoldConstantStages(std::shared_ptr<EvaluationStage>& stage) {
+        if (stage == nullptr) {
+            return 0;
+        }
+
+        if (stage->symbol_ == OperatorSymbol::FUNCTIONAL) {
+            return FoldArgumentStages(stage->right_stage_);
+        }
+
+        size_t removed = FoldConstantStages(stage->left_stage_) + FoldConstantStages(stage->right_stage_);
+
+        switch (stage->symbol_) {
+            case OperatorSymbol::NOOP:
+                if (stage->right_stage_ != nullptr) {
+                    stage = stage->right_stage_;
+                    return removed + 1;
+                }
+                return removed;
+            case OperatorSymbol::LITERAL:
+            case OperatorSymbol::VALUE:
+            case OperatorSymbol::ACCESS:
+            case OperatorSymbol::FUNCTIONAL:
+                return removed;
+            default:
+                break;
+        }
+
+        if (!IsLiteralStage(stage->left_stage_)) {
+            return removed;
+        }
+
+        TokenAvaiableData left, right, value;
+
+        if (stage->left_stage_ != nullptr) {
+            left = stage->left_stage_->value_;
+        }
+
+        try {
+            if (!stage->IsShortCircuitable() || !ShortCircuitStage(stage->symbol_, left, value)) {
+                if (!IsLiteralStage(stage->right_stage_)) {
+                    return removed;
+                }
+
+                if (stage->right_stage_ != nullptr) {
+                    right = stage->right_stage_->value_;
+                }
+
+                value = stage->operator_(left, right, kEmptyParameters);
+            }
+        } catch (const std::exception&) {
+            return removed;
+        }
+
+        removed += CountStages(stage) - 1;
+        stage = MakeLiteralEvaluationStage(value);
+
+        return removed;
+    }
+
+    /*
+        Binds operators whose right operand is a literal to a form prepared once:
+        patterns on the right of `=~` and `!~` are compiled and arrays on the right of `in` are indexed.
+        Runs after the stages are reordered and folded, so the right stage is final and literal lists are arrays.
+        The bound literal moves from the tree into the stage, evaluating it would only copy it.
+    */
+    void PrecompileLiteralOperands(const std::shared_ptr<EvaluationStage>& stage) {
+        if (stage == nullptr) {
+            return;
+        }
+
+        PrecompileLiteralOperands(stage->left_stage_);
+        PrecompileLiteralOperands(stage->right_stage_);
+
+        auto& right = stage->right_stage_;
+        if (right == nullptr || right->symbol_ != OperatorSymbol::LITERAL) {
+            return;
+        }
+
+        switch (stage->symbol_) {
+            case OperatorSymbol::REQ:
+            case OperatorSymbol::NREQ:
+                if (right->value_.is_string()) {
+                    stage->operator_ = MakeRegexStage(right->value_.get<std::string>(), stage->symbol_ == OperatorSymbol::NREQ);
+                    stage->value_ = right->value_;
+                    right = nullptr;
+                }
+                break;
+            case OperatorSymbol::IN:
+                if (right->value_.is_array()) {
+                    stage->operator_ = MakeMembershipStage(right->value_);
+                    stage->value_ = right->value_;
+                    right = nullptr;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    size_t CountStages(const std::shared_ptr<EvaluationStage>& stage) {
+        if (stage == nullptr) {
+            return 0;
+        }
+
+        return 1 + CountStages(stage->left_stage_) + CountStages(stage->right_stage_);
+    }
+
+    /*
+        Key of a stage whose children are already merged, so equal subtrees have equal keys.
+        Returns false for calls to functions that aren't pure, which are never merged.
+    */
+    static bool FindStageKey(const std::shared_ptr<EvaluationStage>& stage, std::string& key) {
+        const void* function = nullptr;
+
+        if (stage->symbol_ == OperatorSymbol::FUNCTIONAL) {
+            function = FindPureFunction(stage->function_);
+            if (function == nullptr) {
+                return false;
+            }
+        }
+
+        // the dumped value goes last, it's the only part of variable length.
+        std::ostringstream stream;
+        stream << static_cast<int>(stage->symbol_) << '|' << stage->left_stage_.get() << '|'
+            << stage->right_stage_.get() << '|' << function << '|' << stage->value_.dump();
+        key = stream.str();
+
+        return true;
+    }
+
+    struct CommonStages {
+        std::unordered_map<std::string, std::shared_ptr<EvaluationStage>> stages;
+        // What each stage already visited was merged into, for stages reached again through another parent.
+        std::unordered_map<const EvaluationStage*, std::shared_ptr<EvaluationStage>> merged;
+    };
+
+    static size_t EliminateCommonStages(std::shared_ptr<EvaluationStage>& stage, CommonStages& common_stages) {
+        if (stage == nullptr) {
+            return 0;
+        }
+
+        auto merged = common_stages.merged.find(stage.get());
+        if (merged != common_stages.merged.end()) {
+            stage = merged->second;
+            return 0;
+        }
+
+        auto original = stage.get();
+        size_t removed = EliminateCommonStages(stage->left_stage_, common_stages) +
+            EliminateCommonStages(stage->right_stage_, common_stages);
+
+        std::string key;
+        if (FindStageKey(stage, key)) {
+            auto common = common_stages.stages.emplace(key, stage);
+            if (!common.second) {
+                stage = common.first->second;
+                removed++;
+            }
+        }
+
+        common_stages.merged.emplace(original, stage);
+
+        return removed;
+    }
+
+    size_t EliminateCommonStages(std::shared_ptr<EvaluationStage>& stage) {
+        std::vector<std::shared_ptr<EvaluationStage>> roots = {stage};
+        auto removed = EliminateCommonStages(roots);
+        stage = roots.front();
+
+        return removed;
+    }
+
+    /*
+        Merges structurally equal subtrees into one stage with several parents, turning the trees into a DAG.
+        Children are merged before their parents, so a repeated subtree is replaced as a whole,
+        and a subtree of one root may be replaced by a subtree of another.
+        Subtrees calling a function not made by `MakePureFunction` are kept apart.
+        Returns the number of stages removed.
+    */
+    size_t EliminateCommonStages(std::vector<std::shared_ptr<EvaluationStage>>& roots) {
+        CommonStages common_stages;
+        size_t removed = 0;
+
+        for (auto& root: roots) {
+            removed += EliminateCommonStages(root, common_stages);
+        }
+
+        return removed;
+    }
+
+    static void NumberSharedStage(EvaluationStage* stage, std::unordered_map<const EvaluationStage*, size_t>& parents,
+            size_t& shared) {
+        auto count = ++parents[stage];
+
+        if (count == 1) {
+            stage->shared_index_ = -1;
+
+            for (auto child: {stage->left_stage_.get(), stage->right_stage_.get()}) {
+                if (child != nullptr) {
+                    NumberSharedStage(child, parents, shared);
+                }
+            }
+            return;
+        }
+
+        // literals and parameters are loaded again, that is cheaper than keeping their value.
+        if (count == 2 && stage->symbol_ != OperatorSymbol::LITERAL && stage->symbol_ != OperatorSymbol::VALUE) {
+            stage->shared_index_ = shared++;
+        }
+    }
+
+    size_t NumberSharedStages(const std::shared_ptr<EvaluationStage>& stage) {
+        return NumberSharedStages(std::vector<std::shared_ptr<EvaluationStage>>{stage});
+    }
+
+    /*
+        Sets `shared_index_` of the stages with several parents left by `EliminateCommonStages`,
+        so evaluation keeps their result and computes them once. Being a root counts as a parent.
+        Returns the number of stages numbered.
+    */
+    size_t NumberSharedStages(const std::vector<std::shared_ptr<EvaluationStage>>& roots) {
+        std::unordered_map<const EvaluationStage*, size_t> parents;
+        size_t shared = 0;
+
+        for (auto& root: roots) {
+            if (root != nullptr) {
+                NumberSharedStage(root.get(), parents, shared);
+            }
+        }
+
+        return shared;
+    }
+
+    static StageType FindValueType(const TokenAvaiableData& value) {
+        switch (value.type()) {
+            case nlohmann::json::value_t::null: return StageType::NIL;
+            case nlohmann::json::value_t::boolean: return StageType::BOOLEAN;
+            case nlohmann::json::value_t::number_integer:
+            case nlohmann::json::value_t::number_unsigned:
+            case nlohmann::json::value_t::number_float: return StageType::NUMERIC;
+            case nlohmann::json::value_t::string: return StageType::STRING;
+            case nlohmann::json::value_t::array: return StageType::ARRAY;
+            case nlohmann::json::value_t::object: return StageType::OBJECT;
+            default: return StageType::UNKNOWN;
+        }
+    }
+
+    // A value of the given type, so the type checks of the stages can be run before evaluation.
+    static TokenAvaiableData MakeSampleValue(StageType type) {
+        switch (type) {
+            case StageType::BOOLEAN: return false;
+            case StageType::NUMERIC: return 0.0;
+            case StageType::STRING: return "";
+            case StageType::ARRAY: return TokenAvaiableData::array();
+            case StageType::OBJECT: return TokenAvaiableData::object();
+            default: return nullptr;
+        }
+    }
+
+    static std::string GetStageTypeName(StageType type) {
+        switch (type) {
+            case StageType::NIL: return "null";
+            case StageType::BOOLEAN: return "bool";
+            case StageType::NUMERIC: return "numeric";
+            case StageType::STRING: return "string";
+            case StageType::ARRAY: return "array";
+            case StageType::OBJECT: return "object";
+            default: return "unknown";
+        }
+    }
+
+    static StageType FindSchemaType(const std::string& name, const ParameterSchema& schema) {
+        auto declared = schema.find(name);
+
+        if (declared == schema.end()) {
+            return StageType::UNKNOWN;
+        }
+
+        return declared->second;
+    }
+
+    static StageType InferResultType(const std::shared_ptr<EvaluationStage>& stage, StageType left_type,
+            StageType right_type, const ParameterSchema& schema) {
+        switch (stage->symbol_) {
+            case OperatorSymbol::LITERAL:
+                return FindValueType(stage->value_);
+            case OperatorSymbol::VALUE:
+                return FindSchemaType(stage->value_.get<std::string>(), schema);
+            case OperatorSymbol::ACCESS: {
+                std::string name;
+                for (auto& field: stage->value_) {
+                    name += (name.empty() ? "" : ".") + field.get<std::string>();
+                }
+                return FindSchemaType(name, schema);
+            }
+            case OperatorSymbol::NOOP:
+                return right_type;
+            case OperatorSymbol::EQ:
+            case OperatorSymbol::NEQ:
+            case OperatorSymbol::GT:
+            case OperatorSymbol::LT:
+            case OperatorSymbol::GTE:
+            case OperatorSymbol::LTE:
+            case OperatorSymbol::REQ:
+            case OperatorSymbol::NREQ:
+            case OperatorSymbol::IN:
+            case OperatorSymbol::AND:
+            case OperatorSymbol::OR:
+            case OperatorSymbol::INVERT:
+                return StageType::BOOLEAN;
+            case OperatorSymbol::MINUS:
+            case OperatorSymbol::MULTIPLY:
+            case OperatorSymbol::DIVIDE:
+            case OperatorSymbol::MODULUS:
+            case OperatorSymbol::EXPONENT:
+            case OperatorSymbol::NEGATE:
+                return StageType::NUMERIC;
+            case OperatorSymbol::PLUS:
+                if (left_type == StageType::STRING || right_type == StageType::STRING) {
+                    return StageType::STRING;
+                }
+                if (left_type == StageType::NUMERIC && right_type == StageType::NUMERIC) {
+                    return StageType::NUMERIC;
+                }
+                return StageType::UNKNOWN;
+            case OperatorSymbol::TERNARY_FALSE:
+            case OperatorSymbol::COALESCE:
+                return left_type == right_type ? left_type : StageType::UNKNOWN;
+            case OperatorSymbol::SEPARATE:
+                return StageType::ARRAY;
+            default:
+                return StageType::UNKNOWN;
+        }
+    }
+
+    static void CheckOperandType(const StageTypeCheck& check, StageType type) {
+        if (check == nullptr || type == StageType::UNKNOWN) {
+            return;
+        }
+
+        if (!check(MakeSampleValue(type))) {
+            throw CvaluateException("Type error: a " + GetStageTypeName(type) + " value can't be used with this operator");
+        }
+    }
+
+    /*
+        Infers the type of every stage from literals and the declared [schema], bottom-up.
+        Operands whose types are known are checked with the type checks of their stage, which raises type errors at planning-time,
+        and stages with operands of the same known type get a specialized operator.
+        The specialized operators keep the generic operator as fallback, since parameters may not match their declared type.
+        Returns the number of specialized stages.
+    */
+    size_t InferStageTypes(const std::shared_ptr<EvaluationStage>& stage, const ParameterSchema& schema) {
+        if (stage == nullptr) {
+            return 0;
+        }
+
+        size_t specialized = InferStageTypes(stage->left_stage_, schema) + InferStageTypes(stage->right_stage_, schema);
+
+        auto left_type = stage->left_stage_ == nullptr ? StageType::UNKNOWN : stage->left_stage_->type_;
+        auto right_type = stage->right_stage_ == nullptr ? StageType::UNKNOWN : stage->right_stage_->type_;
+
+        if (stage->left_stage_ != nullptr) {
+            CheckOperandType(stage->left_type_check_, left_type);
+        }
+        CheckOperandType(stage->right_type_check_, right_type);
+
+        if (stage->type_check_ != nullptr && left_type != StageType::UNKNOWN && right_type != StageType::UNKNOWN &&
+                !stage->type_check_(MakeSampleValue(left_type), MakeSampleValue(right_type))) {
+            throw CvaluateException("Type error: " + GetStageTypeName(left_type) + " and " + GetStageTypeName(right_type) +
+                " values can't be used with this operator");
+        }
+
+        stage->type_ = InferResultType(stage, left_type, right_type, schema);
+
+        auto specialized_operator = FindSpecializedStage(stage->symbol_, left_type, right_type);
+        if (specialized_operator != nullptr) {
+            stage->operator_ = specialized_operator;
+            specialized++;
+        }
+
+        return specialized;
+    }
+
     /*
         The most usual method of parsing an evaluation stage for a given precedence.
         Most stages use the same logic
     */
-    std::shared_ptr<EvaluationStage> PrecedencePlanner::PlanPrecedenceLevel(TokenStream& stream,
-            const StringOperatorSymbolMap* valid_symbols, const std::vector<TokenKind>* valid_kinds,
-            Precedent& right_precedent, Precedent& left_precedent) {
+    std::shared_ptr<EvaluationStage> PrecedencePlanner::PlanPrecedenceLevel(TokenStream& stream) const {
+        auto valid_symbols = this->valid_symbols;
+        auto valid_kinds = this->valid_kinds;
         ExpressionToken token;
         OperatorSymbol symbol = OperatorSymbol::VALUE;
         std::shared_ptr<EvaluationStage> right_stage = nullptr;
@@ -149,8 +598,8 @@ namespace Cvaluate {
         TypeChecks checks;
         bool key_found = false;
 
-        if (left_precedent != nullptr) {
-            left_stage = left_precedent(stream);
+        if (this->next != nullptr) {
+            left_stage = this->next(stream);
         }
 
         while (stream.HasNext()) {
@@ -182,13 +631,15 @@ namespace Cvaluate {
                 }
             }
 
-            if (right_precedent != nullptr) {
-                right_stage = right_precedent(stream);
+            if (this->next_right != nullptr) {
+                right_stage = this->next_right(stream);
+            } else {
+                right_stage = this->PlanPrecedenceLevel(stream);
             }
 
             checks = FindTypeChecks(symbol);
 
-            auto ret = std::make_shared<EvaluationStage>(symbol, left_stage, right_stage, kStageSymbolMap[symbol],
+            auto ret = std::make_shared<EvaluationStage>(symbol, left_stage, right_stage, kStageSymbolMap.at(symbol),
                 checks.left, checks.right, checks.combined);
 
             return ret;
@@ -209,7 +660,8 @@ namespace Cvaluate {
             return nullptr;
         }
         EvaluationOperator plan_operator = nullptr;
-        OperatorSymbol symbol;
+        OperatorSymbol symbol = OperatorSymbol::VALUE;
+        TokenAvaiableData value;
 
         auto token = stream.Next();
 
@@ -234,7 +686,8 @@ namespace Cvaluate {
             }
 
             case TokenKind::VARIABLE: {
-                plan_operator = MakeParameterStage(GetTokenValueString(token->Value));
+                value = GetTokenValueString(token->Value);
+                plan_operator = MakeParameterStage(value);
                 break;
             }
 
@@ -243,7 +696,8 @@ namespace Cvaluate {
             case TokenKind::PATTERN:
             case TokenKind::BOOLEAN: {
                 symbol = OperatorSymbol::LITERAL;
-                plan_operator = MakeLiteralStage(GetTokenValueData(token->Value));
+                value = GetTokenValueData(token->Value);
+                plan_operator = MakeLiteralStage(value);
                 break;
             }
 
@@ -268,6 +722,7 @@ namespace Cvaluate {
             nullptr,
             nullptr
         );
+        ret->value_ = value;
 
         return ret;
     }
@@ -281,16 +736,19 @@ namespace Cvaluate {
         }
 
         auto right_stage = PlanAccessor(stream);
+        auto function = GetTokenValueFunction(token->Value);
 
         auto ret = std::make_shared<EvaluationStage>(
             OperatorSymbol::FUNCTIONAL,
             nullptr,
             right_stage,
-            MakeFunctionStage(GetTokenValueFunction(token->Value)),
+            MakeFunctionStage(function),
             nullptr,
             nullptr,
             nullptr
         );
+        ret->function_ = function;
+        ret->variadic_function_ = FindVariadicFunction(function);
 
         return ret;
     }
@@ -314,15 +772,18 @@ namespace Cvaluate {
             }
         }
 
+        auto names = GetTokenValueData(token->Value);
+
         auto ret = std::make_shared<EvaluationStage>(
             OperatorSymbol::ACCESS,
             nullptr,
             nullptr,
-            MakeAccessorStage(GetTokenValueData(token->Value)),
+            MakeAccessorStage(names),
             nullptr,
             nullptr,
             nullptr
         );
+        ret->value_ = names;
 
         return ret;
     }
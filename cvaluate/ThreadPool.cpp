@@ -0,0 +1,108 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <cvaluate/ThreadPool.h>
+
+namespace Cvaluate {
+    // Identifies the pool and queue of the worker running on this thread.
+    static thread_local const ThreadPool* current_pool = nullptr;
+    static thread_local size_t current_queue = 0;
+
+    ThreadPool::ThreadPool(size_t threads) {
+        threads = std::max<size_t>(threads, 1);
+
+        for (size_t i = 0; i < threads; i++) {
+            this->queues_.push_back(std::make_unique<WorkQueue>());
+        }
+
+        for (size_t i = 0; i < threads; i++) {
+            this->workers_.emplace_back([this, i] { this->Work(i); });
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            this->stopping_ = true;
+        }
+        this->wake_.notify_all();
+
+        for (auto& worker: this->workers_) {
+            worker.join();
+        }
+    }
+
+    void ThreadPool::Submit(std::function<void()> task) {
+        auto index = current_pool == this ? current_queue : this->next_queue_++ % this->queues_.size();
+
+        {
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            {
+                std::lock_guard<std::mutex> queue_lock(this->queues_[index]->mutex);
+                this->queues_[index]->tasks.push_back(std::move(task));
+            }
+            this->pending_++;
+        }
+        this->wake_.notify_one();
+    }
+
+    bool ThreadPool::TryRun(size_t index) {
+        std::function<void()> task;
+
+        for (size_t i = 0; i < this->queues_.size() && !task; i++) {
+            auto& queue = *this->queues_[(index + i) % this->queues_.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+
+            if (queue.tasks.empty()) {
+                continue;
+            }
+
+            // the newest task of its own queue is the most likely to be cache hot, steal the oldest of the others.
+            if (i == 0) {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            } else {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+        }
+
+        if (!task) {
+            return false;
+        }
+
+        this->pending_--;
+        task();
+        return true;
+    }
+
+    void ThreadPool::Work(size_t index) {
+        current_pool = this;
+        current_queue = index;
+
+        for (;;) {
+            if (this->TryRun(index)) {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(this->mutex_);
+            this->wake_.wait(lock, [this] { return this->stopping_ || this->pending_ > 0; });
+
+            if (this->stopping_ && this->pending_ == 0) {
+                return;
+            }
+        }
+    }
+} // Cvaluate
@@ -40,7 +40,7 @@ namespace Cvaluate {
         return false;
     }
 
-    std::string GetTokenValueString(TokenAvaiableData token_data) {
+    std::string GetTokenValueString(const TokenAvaiableData& token_data) {
         if (token_data.is_string()) {
             return token_data.get<std::string>();
         } else if (token_data.is_number_integer()) {
@@ -58,7 +58,7 @@ namespace Cvaluate {
         }
     }
 
-    std::string GetTokenValueString(TokenAvaiableValue token_value) {
+    std::string GetTokenValueString(const TokenAvaiableValue& token_value) {
         auto token_data = GetTokenValueData(token_value);
         if (token_data.is_string()) {
             return token_data.get<std::string>();
@@ -67,7 +67,7 @@ namespace Cvaluate {
         }
     }
 
-    int GetTokenValueInt(TokenAvaiableData token_data) {
+    int GetTokenValueInt(const TokenAvaiableData& token_data) {
         if (token_data.is_number_integer()) {
             return token_data.get<int>();
         } else {
@@ -75,7 +75,7 @@ namespace Cvaluate {
         }
     }
 
-    float GetTokenValueFloat(TokenAvaiableData token_data) {
+    float GetTokenValueFloat(const TokenAvaiableData& token_data) {
         if (token_data.is_number_float()) {
             return token_data.get<float>();
         } else {
@@ -84,7 +84,7 @@ namespace Cvaluate {
     }
 
 
-    float GetTokenValueNumeric(TokenAvaiableData token_data) {
+    float GetTokenValueNumeric(const TokenAvaiableData& token_data) {
         if (token_data.is_number_float()) {
             return token_data.get<float>();
         } else if (token_data.is_number_integer()) {
@@ -94,7 +94,7 @@ namespace Cvaluate {
         }
     }
 
-    bool GetTokenValueBool(TokenAvaiableData token_data) {
+    bool GetTokenValueBool(const TokenAvaiableData& token_data) {
         if (token_data.is_boolean()) {
             return token_data.get<bool>();
         } else {
@@ -125,4 +125,70 @@ namespace Cvaluate {
             throw CvaluateException("Can't get TokenAvaiableData from current token");
         }
     }
+
+    ExpressionFunction MakePureFunction(ExpressionFunction function) {
+        return PureFunction(std::move(function));
+    }
+
+    const void* FindPureFunction(const ExpressionFunction& function) {
+        if (auto pure = function.target<PureFunction>()) {
+            return pure->Identity();
+        }
+
+        return nullptr;
+    }
+
+    TokenAvaiableData VariadicCall::operator()(TokenAvaiableData argument) const {
+        if (argument.is_null()) {
+            return (*this->function_)(FunctionArguments(nullptr, 0));
+        }
+
+        if (!argument.is_array()) {
+            const TokenAvaiableData* only = &argument;
+            return (*this->function_)(FunctionArguments(&only, 1));
+        }
+
+        ArgumentBuffer<const TokenAvaiableData*> arguments(argument.size());
+        for (size_t i = 0; i < argument.size(); i++) {
+            arguments.Data()[i] = &argument[i];
+        }
+
+        return (*this->function_)(FunctionArguments(arguments.Data(), argument.size()));
+    }
+
+    ExpressionFunction MakeVariadicFunction(VariadicFunction function) {
+        return VariadicCall(std::move(function));
+    }
+
+    /*
+        Arguments are packed like the separators used to build them:
+        an array first argument is extended by the others instead of nested.
+    */
+    VariadicFunction FindVariadicFunction(const ExpressionFunction& function) {
+        auto wrapped = &function;
+        if (auto pure = function.target<PureFunction>()) {
+            wrapped = &pure->Function();
+        }
+
+        if (auto variadic = wrapped->target<VariadicCall>()) {
+            return variadic->Function();
+        }
+
+        return [function](const FunctionArguments& arguments) -> TokenAvaiableData {
+            if (arguments.empty()) {
+                return function(nullptr);
+            }
+
+            if (arguments.size() == 1) {
+                return function(arguments[0]);
+            }
+
+            TokenAvaiableData packed = arguments[0].is_array() ? arguments[0] : TokenAvaiableData::array({arguments[0]});
+            for (size_t i = 1; i < arguments.size(); i++) {
+                packed.push_back(arguments[i]);
+            }
+
+            return function(std::move(packed));
+        };
+    }
 } // Cvaluate
\ No newline at end of file
@@ -0,0 +1,211 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <cvaluate/Value.h>
+#include <cvaluate/Exception.h>
+
+#include <cstring>
+
+namespace Cvaluate {
+    Value Value::Boolean(bool value) {
+        Value ret;
+        ret.type_ = Type::BOOLEAN;
+        ret.boolean_ = value;
+        return ret;
+    }
+
+    Value Value::Integer(int64_t value) {
+        Value ret;
+        ret.type_ = Type::INTEGER;
+        ret.integer_ = value;
+        return ret;
+    }
+
+    Value Value::Float(double value) {
+        Value ret;
+        ret.type_ = Type::FLOAT;
+        ret.float_ = value;
+        return ret;
+    }
+
+    Value Value::String(std::string_view value) {
+        if (value.size() > UINT32_MAX) {
+            throw CvaluateException("String is too long");
+        }
+
+        Value ret;
+        ret.size_ = value.size();
+
+        if (value.size() <= sizeof(ret.chars_)) {
+            ret.type_ = Type::SHORT_STRING;
+            std::memcpy(ret.chars_, value.data(), value.size());
+        } else {
+            ret.type_ = Type::STRING;
+            ret.string_ = value.data();
+        }
+
+        return ret;
+    }
+
+    Value Value::Borrow(const TokenAvaiableData& value) {
+        switch (value.type()) {
+            case nlohmann::json::value_t::null:
+                return Value();
+            case nlohmann::json::value_t::boolean:
+                return Boolean(value.get<bool>());
+            case nlohmann::json::value_t::number_integer:
+            case nlohmann::json::value_t::number_unsigned:
+                return Integer(value.get<int64_t>());
+            case nlohmann::json::value_t::number_float:
+                return Float(value.get<double>());
+            case nlohmann::json::value_t::string:
+                return String(value.get_ref<const std::string&>());
+            default: {
+                Value ret;
+                ret.type_ = Type::JSON;
+                ret.json_ = &value;
+                return ret;
+            }
+        }
+    }
+
+    bool Value::GetBool() const {
+        if (this->type_ != Type::BOOLEAN) {
+            throw CvaluateException("Can't get bool from current token");
+        }
+
+        return this->boolean_;
+    }
+
+    float Value::GetNumeric() const {
+        switch (this->type_) {
+            case Type::FLOAT:
+                return float(this->float_);
+            case Type::INTEGER:
+                return int(this->integer_);
+            default:
+                throw CvaluateException("Can't get float from current token");
+        }
+    }
+
+    std::string_view Value::GetStringView() const {
+        switch (this->type_) {
+            case Type::SHORT_STRING:
+                return std::string_view(this->chars_, this->size_);
+            case Type::STRING:
+                return std::string_view(this->string_, this->size_);
+            default:
+                throw CvaluateException("Can't get string from current token");
+        }
+    }
+
+    void Value::AppendString(std::string& output) const {
+        switch (this->type_) {
+            case Type::SHORT_STRING:
+            case Type::STRING:
+                output.append(this->GetStringView());
+                return;
+            case Type::INTEGER:
+                output.append(std::to_string(int(this->integer_)));
+                return;
+            case Type::FLOAT:
+                output.append(std::to_string(int(float(this->float_))));
+                return;
+            case Type::BOOLEAN:
+                output.append(this->boolean_ ? "true" : "false");
+                return;
+            default:
+                throw CvaluateException("Can't get string from current token");
+        }
+    }
+
+    TokenAvaiableData Value::ToJson() const {
+        switch (this->type_) {
+            case Type::BOOLEAN:
+                return this->boolean_;
+            case Type::INTEGER:
+                return this->integer_;
+            case Type::FLOAT:
+                return this->float_;
+            case Type::SHORT_STRING:
+            case Type::STRING:
+                return std::string(this->GetStringView());
+            case Type::JSON:
+                return *this->json_;
+            default:
+                return nullptr;
+        }
+    }
+
+    void Value::AssignTo(TokenAvaiableData& target) const {
+        if (!this->IsString()) {
+            target = this->ToJson();
+            return;
+        }
+
+        if (target.is_string()) {
+            target.get_ref<std::string&>().assign(this->GetStringView());
+        } else {
+            target = std::string(this->GetStringView());
+        }
+    }
+
+    std::string& ValueArena::NewString() {
+        if (this->used_strings_ == this->strings_.size()) {
+            this->strings_.push_back(std::make_unique<std::string>());
+        }
+
+        auto& ret = *this->strings_[this->used_strings_++];
+        ret.clear();
+        return ret;
+    }
+
+    Value ValueArena::Store(TokenAvaiableData&& value) {
+        if (this->used_values_ == this->values_.size()) {
+            this->values_.push_back(std::make_unique<TokenAvaiableData>());
+        }
+
+        auto& ret = *this->values_[this->used_values_++];
+        ret = std::move(value);
+        return Value::Borrow(ret);
+    }
+
+    /*
+        Objects and arrays are borrowed as they are, the other values are converted into storage
+        kept from the previous calls, so only a longer string than before allocates.
+    */
+    FunctionArguments ValueArena::Arguments(const Value* values, size_t count) {
+        if (this->arguments_.size() < count) {
+            this->arguments_.resize(count);
+            this->argument_pointers_.resize(count);
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            auto json = values[i].GetJson();
+            if (json == nullptr) {
+                values[i].AssignTo(this->arguments_[i]);
+                json = &this->arguments_[i];
+            }
+            this->argument_pointers_[i] = json;
+        }
+
+        return FunctionArguments(this->argument_pointers_.data(), count);
+    }
+
+    void ValueArena::Reset() {
+        this->used_strings_ = 0;
+        this->used_values_ = 0;
+    }
+} // Cvaluate
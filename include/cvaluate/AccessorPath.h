@@ -0,0 +1,43 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef CVALUATE_ACCESSOR_PATH
+#define CVALUATE_ACCESSOR_PATH
+
+#include "./Token.h"
+
+namespace Cvaluate {
+    /*
+        An accessor chain like `foo.Nested.Funk`, converted once from the names of its token.
+        Resolving walks the fields by const reference and never inserts missing keys,
+        a missing field or a field of null resolves to null.
+    */
+    class AccessorPath {
+        private:
+            std::string root_;
+            std::vector<std::string> fields_;
+        public:
+            explicit AccessorPath(const TokenAvaiableData& names);
+
+            // Return the variable name the chain starts from.
+            const std::string& Root() const;
+
+            // Return the value at the end of the chain, [root] being the value of the variable.
+            const TokenAvaiableData& Resolve(const TokenAvaiableData& root) const;
+    };
+} // Cvaluate
+
+#endif
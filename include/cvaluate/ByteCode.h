@@ -0,0 +1,135 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef CVALUATE_BYTE_CODE
+#define CVALUATE_BYTE_CODE
+
+#include <optional>
+
+#include "./EvaluationStage.h"
+#include "./ParameterFrame.h"
+#include "./Value.h"
+
+namespace Cvaluate {
+    /*
+        Instructions of the stack machine.
+        Every instruction pops its operands from the value stack and pushes exactly one result,
+        so a compiled stage tree leaves its value as the only element on the stack.
+        Jumps implement short-circuiting: they inspect the top of the stack and, when it decides the result,
+        leave the result there and continue after the right operand.
+    */
+    enum class OpCode : uint8_t {
+        PUSH_CONSTANT,
+        PUSH_NULL,
+        LOAD_PARAMETER,
+        LOAD_ACCESSOR,
+        CALL_FUNCTION,
+        // Operators without a dedicated opcode, dispatched through the stage operator.
+        CALL_OPERATOR,
+        // Push the kept result of a shared stage and jump past its code, or fall through to compute it.
+        LOAD_SHARED,
+        // Keep the top of the stack as the result of a shared stage.
+        STORE_SHARED,
+
+        JUMP_IF_FALSE,
+        JUMP_IF_TRUE,
+        JUMP_IF_NOT_NULL,
+        JUMP_NULL_IF_FALSE,
+
+        ADD,
+        SUBTRACT,
+        MULTIPLY,
+        DIVIDE,
+        EXPONENT,
+        MODULUS,
+        GTE,
+        GT,
+        LTE,
+        LT,
+        EQ,
+        NEQ,
+        AND,
+        OR,
+        TERNARY_IF,
+        TERNARY_ELSE,
+        SEPARATE,
+
+        NEGATE,
+        INVERT,
+    };
+
+    struct Instruction {
+        OpCode code;
+        uint32_t operand;
+    };
+
+    // Operand of `CALL_FUNCTION`: the function and how many arguments it takes from the stack.
+    struct FunctionCall {
+        VariadicFunction function;
+        uint32_t arguments;
+    };
+
+    // Operand of `LOAD_SHARED`: the shared stage and the instruction after the code computing it.
+    struct SharedLoad {
+        uint32_t index;
+        uint32_t end;
+    };
+
+    /*
+        A planned stage tree flattened into post-order instructions.
+        Operands of the instructions index into the tables of the program.
+        Every distinct variable name, used alone or as the root of an accessor, is assigned a slot;
+        `slots` maps each slot to its name and parameters are loaded from a `ParameterFrame` by slot.
+        A shared stage is compiled at each of its parents, guarded so only the first one reached computes it.
+    */
+    struct ByteCodeProgram {
+        std::vector<Instruction> instructions;
+        std::vector<TokenAvaiableData> constants;
+        std::vector<std::string> slots;
+        std::vector<AccessorPath> accessors;
+        std::vector<uint32_t> accessor_slots;
+        std::vector<FunctionCall> functions;
+        std::vector<EvaluationOperator> operators;
+        std::vector<SharedLoad> shared_loads;
+        size_t shared_count = 0;
+        size_t max_stack_depth = 0;
+    };
+
+    ByteCodeProgram CompileStages(std::shared_ptr<EvaluationStage> root_stage);
+    ParameterFrame BindParameters(const std::vector<std::string>& slots, const Parameters& parameters);
+    void BindParameters(ParameterFrame& frame, const std::vector<std::string>& slots, const Parameters& parameters);
+
+    /*
+        Executes programs on a stack of compact `Value`s, borrowing parameters and constants instead of copying them.
+        Results of operators that only exist for `TokenAvaiableData` are converted and kept in the arena
+        until the next execution.
+    */
+    class VirtualMachine {
+        private:
+            std::vector<Value> stack_;
+            std::vector<std::optional<Value>> shared_;
+            ValueArena arena_;
+
+            const Value& Run(const ByteCodeProgram& program, const ParameterFrame& frame);
+        public:
+            TokenAvaiableData Execute(const ByteCodeProgram& program, const Parameters& parameters);
+            TokenAvaiableData Execute(const ByteCodeProgram& program, const ParameterFrame& frame);
+            // Execute a program whose result must be a bool, without converting it to `TokenAvaiableData`.
+            bool ExecuteBool(const ByteCodeProgram& program, const ParameterFrame& frame);
+    };
+} // Cvaluate
+
+#endif
@@ -0,0 +1,66 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef CVALUATE_CLOSURE
+#define CVALUATE_CLOSURE
+
+#include <deque>
+
+#include "./ByteCode.h"
+
+namespace Cvaluate {
+    class ClosureNode;
+
+    /*
+        A planned stage tree compiled into nested, statically typed nodes.
+        Each node is specialized by template on its operator and on how its operands are loaded,
+        so constants, parameters and accessors are read inline by their parent node
+        and operators are called directly instead of through `EvaluationOperator`.
+    */
+    class ClosureProgram {
+        private:
+            // Constants borrowed by the nodes, a deque keeps their addresses stable.
+            std::deque<TokenAvaiableData> constants_;
+            std::unique_ptr<ClosureNode> root_;
+            size_t slot_count_ = 0;
+            size_t shared_count_ = 0;
+
+            friend class ClosureCompiler;
+        public:
+            ClosureProgram();
+            ~ClosureProgram();
+            ClosureProgram(const ClosureProgram&) = delete;
+            ClosureProgram& operator=(const ClosureProgram&) = delete;
+
+            TokenAvaiableData Execute(const ParameterFrame& frame) const;
+            // Execute reusing the storage of [arena], which is reset first.
+            TokenAvaiableData Execute(const ParameterFrame& frame, ValueArena& arena) const;
+            bool ExecuteBool(const ParameterFrame& frame, ValueArena& arena) const;
+        private:
+            Value Run(const ParameterFrame& frame, ValueArena& arena) const;
+    };
+
+    /**
+     * Compile a planned stage tree, loading variables from the given slots.
+     *
+     * @param root_stage Planned stage tree.
+     * @param slots Variable names indexed by slot, as assigned by `CompileStages`.
+     */
+    std::shared_ptr<ClosureProgram> CompileClosures(const std::shared_ptr<EvaluationStage>& root_stage,
+        const std::vector<std::string>& slots);
+} // Cvaluate
+
+#endif
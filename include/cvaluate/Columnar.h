@@ -0,0 +1,173 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef CVALUATE_COLUMNAR
+#define CVALUATE_COLUMNAR
+
+#include "./EvaluationStage.h"
+
+namespace Cvaluate {
+    /*
+        Packed bits, one per row.
+    */
+    class Bitmap {
+        private:
+            std::vector<uint64_t> words_;
+            size_t size_ = 0;
+        public:
+            Bitmap() {};
+            explicit Bitmap(size_t size, bool value = false);
+
+            bool Get(size_t index) const {
+                return (this->words_[index / 64] >> (index % 64)) & 1;
+            }
+
+            void Set(size_t index, bool value);
+
+            size_t Size() const {
+                return this->size_;
+            }
+
+            bool Empty() const {
+                return this->size_ == 0;
+            }
+
+            // Return the number of set bits.
+            size_t Count() const;
+
+            const std::vector<uint64_t>& Words() const {
+                return this->words_;
+            }
+    };
+
+    enum class ColumnType : uint8_t {
+        NUMERIC,
+        BOOLEAN,
+        STRING,
+    };
+
+    /*
+        Values of one variable for every row of a batch, stored contiguously by type.
+        Set bits of the null bitmap mark null rows, an empty bitmap means no row is null.
+        Booleans take a byte per row, since std::vector<bool> isn't contiguous.
+    */
+    class Column {
+        private:
+            ColumnType type_;
+            size_t size_ = 0;
+            std::vector<float> numbers_;
+            std::vector<uint8_t> booleans_;
+            std::vector<std::string> strings_;
+            Bitmap nulls_;
+
+            Column(ColumnType type, size_t size, Bitmap nulls);
+        public:
+            static Column Numeric(std::vector<float> values, Bitmap nulls = {});
+            static Column Boolean(std::vector<uint8_t> values, Bitmap nulls = {});
+            static Column String(std::vector<std::string> values, Bitmap nulls = {});
+
+            ColumnType Type() const {
+                return this->type_;
+            }
+
+            size_t Size() const {
+                return this->size_;
+            }
+
+            bool IsNull(size_t row) const {
+                return !this->nulls_.Empty() && this->nulls_.Get(row);
+            }
+
+            const std::vector<float>& Numbers() const {
+                return this->numbers_;
+            }
+
+            const std::vector<uint8_t>& Booleans() const {
+                return this->booleans_;
+            }
+
+            const std::vector<std::string>& Strings() const {
+                return this->strings_;
+            }
+
+            const Bitmap& Nulls() const {
+                return this->nulls_;
+            }
+
+            // Return the value of [row], null for null rows.
+            TokenAvaiableData Get(size_t row) const;
+
+            // Return the rows of a boolean column that are true, null rows are not.
+            Bitmap Matches() const;
+    };
+
+    /*
+        Columnar parameters: one column per variable name, or per accessor chain like "r.sub".
+    */
+    class ColumnBatch {
+        private:
+            size_t rows_;
+            std::unordered_map<std::string, Column> columns_;
+        public:
+            explicit ColumnBatch(size_t rows) : rows_(rows) {};
+
+            void Add(const std::string& name, Column column);
+
+            // Return the column named [name], or nullptr if there is none.
+            const Column* Find(const std::string& name) const;
+
+            size_t Rows() const {
+                return this->rows_;
+            }
+
+            const std::unordered_map<std::string, Column>& Columns() const {
+                return this->columns_;
+            }
+
+            // Return the parameters of one row, nesting accessor columns into objects.
+            Parameters GetRow(size_t row) const;
+    };
+
+    /*
+        Instruction sets the column kernels are compiled for, picked at runtime.
+    */
+    enum class SimdLevel {
+        SCALAR,
+        SSE4_2,
+        AVX2,
+        AVX512,
+    };
+
+    // Return the best level supported by the running CPU.
+    SimdLevel DetectSimdLevel();
+
+    using RowEvaluator = std::function<TokenAvaiableData(const Parameters&)>;
+
+    /**
+     * Evaluate a planned stage tree over every row of [batch] with one kernel call per stage.
+     * Rows whose evaluation would throw, like comparing a null, are null in the result.
+     * Trees with stages the kernels don't cover are evaluated row by row with [row_evaluator].
+     *
+     * @param root_stage Planned stage tree.
+     * @param batch Columnar parameters.
+     * @param level Instruction set of the kernels, lowered to the best one the CPU supports.
+     * @param row_evaluator Fallback evaluation of a single row.
+     */
+    Column EvaluateColumns(const std::shared_ptr<EvaluationStage>& root_stage, const ColumnBatch& batch,
+        SimdLevel level, const RowEvaluator& row_evaluator);
+} // Cvaluate
+
+#endif
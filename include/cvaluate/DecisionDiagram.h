@@ -0,0 +1,97 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef CVALUATE_DECISION_DIAGRAM
+#define CVALUATE_DECISION_DIAGRAM
+
+#include "./Parising.h"
+#include "./StagePlanner.h"
+
+namespace Cvaluate {
+    /*
+        Boolean expressions compiled into one reduced ordered binary decision diagram.
+        The `&&`, `||` and `!` stages of the expressions become the structure of the diagram; every other stage,
+        like `r.amount > 1000`, is a predicate, and equal predicates of different expressions are the same predicate.
+        Evaluating follows one path per expression through a flat array of nodes and tests each predicate
+        at most once for all the expressions.
+        Predicates are tested in the order they first appear in the expressions, so a predicate the expression
+        would have skipped by short-circuiting may be tested, and its errors raised.
+        A predicate the expression would have tested may also be skipped when another one decides the result,
+        so its errors are suppressed: with `a` false, `b && a` is false even when `b` isn't a bool.
+        The order can make the diagram grow exponentially with the number of predicates,
+        so building stops with an error past a limit on the number of nodes.
+    */
+    class DecisionDiagram {
+        private:
+            struct DecisionNode {
+                uint32_t predicate;
+                // Next node when the predicate is false, and when it is true.
+                uint32_t low;
+                uint32_t high;
+            };
+
+            std::vector<std::shared_ptr<EvaluationStage>> stages_;
+            std::vector<std::shared_ptr<EvaluationStage>> predicates_;
+            std::vector<DecisionNode> nodes_;
+            std::vector<uint32_t> roots_;
+            size_t shared_stages_ = 0;
+
+            friend class DiagramBuilder;
+
+            bool Follow(uint32_t node, const Parameters& parameters, std::vector<int8_t>& tested,
+                SharedStageResults& shared) const;
+        public:
+            // Nodes 0 and 1 are the false and true results.
+            static constexpr uint32_t kFalse = 0;
+            static constexpr uint32_t kTrue = 1;
+            static constexpr size_t kDefaultNodeLimit = 1 << 18;
+
+            /**
+             * @param expressions Boolean expressions, indexed by their position.
+             * @param functions Functions the expressions may call.
+             * @param schema Declared types of parameters, shared by the expressions.
+             * @param node_limit Most nodes building may make, intermediate ones included;
+             *     past it the expressions are better evaluated with an `ExpressionSet`.
+             */
+            explicit DecisionDiagram(const std::vector<std::string>& expressions, const ExpressionFunctionMap& functions = {},
+                const ParameterSchema& schema = {}, size_t node_limit = kDefaultNodeLimit);
+
+            size_t Size() const;
+
+            // Number of distinct predicates of the expressions.
+            size_t Predicates() const;
+
+            // Number of decision nodes shared by the expressions, not counting the two results.
+            size_t Nodes() const;
+
+            /**
+             * Evaluate every expression, testing each predicate at most once.
+             *
+             * @param parameters Parameters of all the expressions.
+             */
+            std::vector<bool> Evaluate(const Parameters& parameters) const;
+
+            /**
+             * Evaluate the expression at [index].
+             *
+             * @param parameters Parameters of the expression.
+             * @param index Position of the expression.
+             */
+            bool Evaluate(const Parameters& parameters, size_t index) const;
+    };
+} // Cvaluate
+
+#endif
@@ -21,31 +21,201 @@
 #include "./Token.h"
 #include "./Parising.h"
 #include "./StagePlanner.h"
+#include "./ByteCode.h"
+#include "./Closure.h"
+#include "./Columnar.h"
+#include "./ThreadPool.h"
 
 namespace Cvaluate {
 
+/*
+    How `Evaluate` executes the planned stages.
+    TREE_WALK recursively walks the stage tree, BYTECODE runs the tree compiled for the `VirtualMachine`,
+    CLOSURE runs the tree compiled into statically typed nodes.
+*/
+enum class EvaluationMode {
+    TREE_WALK,
+    BYTECODE,
+    CLOSURE,
+};
+
+/*
+    The planned and compiled expression is read only once constructed: const members can run on many threads at once,
+    each evaluation keeps its scratch state on its own stack. `SetEvaluationMode` must not run concurrently with them.
+*/
 class EvaluableExpression {
     private:
         std::string e_input;
         std::vector<ExpressionToken> e_tokens;
         std::shared_ptr<EvaluationStage> e_evaluation_stage;
+        PlanStatistics e_statistics;
+        EvaluationMode e_mode = EvaluationMode::TREE_WALK;
+        std::shared_ptr<ByteCodeProgram> e_program;
+        std::shared_ptr<ClosureProgram> e_closure;
 
-        TokenAvaiableData EvaluateStage(std::shared_ptr<EvaluationStage>, Parameters);
+        template <typename Result, typename Visitor>
+        void VisitRows(const Parameters* rows, size_t count, Visitor visit) const;
+        template <typename Result>
+        void EvaluateRows(const Parameters* rows, size_t count, Result* results) const;
+        template <typename Result>
+        void EvaluateRowsParallel(const Parameters* rows, size_t count, Result* results, Executor& executor, size_t chunk_size) const;
+        size_t FindRow(const Parameters* rows, size_t count, bool expected) const;
+        size_t FindRowParallel(const Parameters* rows, size_t count, bool expected, Executor& executor, size_t chunk_size) const;
+        size_t CountRows(const Parameters* rows, size_t count) const;
     public:
         /**
          * Default constructor.
          * 
          * @param expression Eavl expression.
+         * @param functions Functions the expression may call.
+         * @param schema Declared types of parameters, used to report type errors and specialize operators.
          */
         EvaluableExpression(std::string expression, 
-            ExpressionFunctionMap functions = {});
+            ExpressionFunctionMap functions = {},
+            const ParameterSchema& schema = {});
 
         /**
          * Return Tokens copy
          */
         std::vector<ExpressionToken> Tokens();
 
-        TokenAvaiableData Evaluate(Parameters = {});
+        /**
+         * Return what the planner's optimization passes did to the expression.
+         */
+        const PlanStatistics& Statistics() const;
+
+        /**
+         * Return the root of the planned stages, owned by the expression.
+         */
+        const EvaluationStage* Stages() const;
+
+        /**
+         * Return the variable names of the expression, indexed by their slot.
+         */
+        const std::vector<std::string>& ParameterSlots() const;
+
+        /**
+         * Return the slot of a variable, or -1 if the expression doesn't use it.
+         *
+         * @param name Variable name.
+         */
+        int FindParameterSlot(const std::string& name) const;
+
+        /**
+         * Return an empty frame sized for the slots of the expression.
+         */
+        ParameterFrame MakeParameterFrame() const;
+
+        /**
+         * Select how the expression is evaluated, compiling it on first use of the closure mode.
+         *
+         * @param mode Evaluation mode.
+         */
+        void SetEvaluationMode(EvaluationMode mode);
+
+        EvaluationMode GetEvaluationMode() const;
+
+        TokenAvaiableData Evaluate(const Parameters& = kEmptyParameters) const;
+
+        /**
+         * Evaluate with variables bound by slot, skipping the name lookups.
+         * Runs the closures in CLOSURE mode and the byte code otherwise.
+         *
+         * @param frame Values bound to the slots of `ParameterSlots()`.
+         */
+        TokenAvaiableData Evaluate(const ParameterFrame& frame) const;
+
+        /**
+         * Evaluate once per parameter set, reusing the frame and scratch storage of the evaluation mode across rows.
+         * If a row fails, the exception is thrown with the results of the previous rows already written.
+         *
+         * @param rows Parameter sets.
+         * @param count Number of rows.
+         * @param results Output, one result per row.
+         */
+        void EvaluateBatch(const Parameters* rows, size_t count, TokenAvaiableData* results) const;
+
+        /**
+         * Evaluate a boolean expression once per parameter set, throwing if a result isn't a bool.
+         *
+         * @param rows Parameter sets.
+         * @param count Number of rows.
+         * @param results Output, one result per row.
+         */
+        void EvaluateBatch(const Parameters* rows, size_t count, bool* results) const;
+
+        std::vector<TokenAvaiableData> EvaluateBatch(const std::vector<Parameters>& rows) const;
+
+        /**
+         * Evaluate once per parameter set, splitting the rows into chunks run by [executor] and the calling thread.
+         * Every result is written at the index of its row, so the output doesn't depend on the scheduling.
+         * If a row fails, the remaining chunks are skipped and the first exception is thrown once the running chunks are done.
+         *
+         * @param rows Parameter sets.
+         * @param count Number of rows.
+         * @param results Output, one result per row.
+         * @param executor Runs the chunks besides the calling thread.
+         * @param chunk_size Rows evaluated per task.
+         */
+        void EvaluateBatchParallel(const Parameters* rows, size_t count, TokenAvaiableData* results,
+            Executor& executor, size_t chunk_size = 1024) const;
+
+        /**
+         * Evaluate a boolean expression once per parameter set in parallel, throwing if a result isn't a bool.
+         *
+         * @param rows Parameter sets.
+         * @param count Number of rows.
+         * @param results Output, one result per row.
+         * @param executor Runs the chunks besides the calling thread.
+         * @param chunk_size Rows evaluated per task.
+         */
+        void EvaluateBatchParallel(const Parameters* rows, size_t count, bool* results,
+            Executor& executor, size_t chunk_size = 1024) const;
+
+        std::vector<TokenAvaiableData> EvaluateBatchParallel(const std::vector<Parameters>& rows, Executor& executor) const;
+
+        /**
+         * Return whether a boolean expression is true for any row, stopping at the first row where it is.
+         * Rows are evaluated in order, if one fails or isn't a bool before that the exception is thrown.
+         *
+         * @param rows Parameter sets.
+         * @param count Number of rows.
+         */
+        bool EvaluateAny(const Parameters* rows, size_t count) const;
+
+        /**
+         * Return whether a boolean expression is true for any row, splitting the rows into chunks run by [executor]
+         * and the calling thread. Once a row decides the result, the chunks after it stop.
+         * The result and the exception thrown are the same as evaluating the rows in order.
+         *
+         * @param rows Parameter sets.
+         * @param count Number of rows.
+         * @param executor Runs the chunks besides the calling thread.
+         * @param chunk_size Rows evaluated per task.
+         */
+        bool EvaluateAny(const Parameters* rows, size_t count, Executor& executor, size_t chunk_size = 1024) const;
+
+        // Return whether a boolean expression is true for every row, stopping at the first row where it is false.
+        bool EvaluateAll(const Parameters* rows, size_t count) const;
+        bool EvaluateAll(const Parameters* rows, size_t count, Executor& executor, size_t chunk_size = 1024) const;
+
+        // Return the index of the first row where a boolean expression is true, or [count] if there is none.
+        size_t EvaluateFirst(const Parameters* rows, size_t count) const;
+        size_t EvaluateFirst(const Parameters* rows, size_t count, Executor& executor, size_t chunk_size = 1024) const;
+
+        // Return the number of rows where a boolean expression is true, every row is evaluated.
+        size_t EvaluateCount(const Parameters* rows, size_t count) const;
+        size_t EvaluateCount(const Parameters* rows, size_t count, Executor& executor, size_t chunk_size = 1024) const;
+
+        /**
+         * Evaluate over columnar parameters, one vectorized kernel per stage instead of one pass per row.
+         * Rows whose evaluation would throw are null in the result.
+         * Expressions using operators without a kernel fall back to `Evaluate` row by row.
+         *
+         * @param batch One column per variable name or accessor chain.
+         * @param level Instruction set of the kernels.
+         */
+        Column EvaluateColumns(const ColumnBatch& batch, SimdLevel level = DetectSimdLevel()) const;
 };  
 
 }
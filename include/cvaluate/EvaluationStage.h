@@ -17,16 +17,33 @@
 #ifndef EVALUATION_STAGE_SYMBOL
 #define EVALUATION_STAGE_SYMBOL
 
+#include <optional>
+
 #include "./pch.h"
 #include "./Token.h"
 #include "./OperatorSymbol.h"
+#include "./AccessorPath.h"
 
 namespace Cvaluate {
     using Parameters = std::unordered_map<std::string, TokenAvaiableData>;
-    // Parameters kEmptyParameters;
-    using EvaluationOperator = std::function<TokenAvaiableData(TokenAvaiableData, TokenAvaiableData, Parameters)>;
-    using StageTypeCheck = std::function<bool(TokenAvaiableData&)>;
-    using StageCombinedTypeCheck = std::function<bool(TokenAvaiableData&, TokenAvaiableData&)>;
+    extern const Parameters kEmptyParameters;
+    // Operands and parameters are borrowed for the duration of the call, the result is returned by value.
+    using EvaluationOperator = std::function<TokenAvaiableData(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters&)>;
+    using StageTypeCheck = std::function<bool(const TokenAvaiableData&)>;
+    using StageCombinedTypeCheck = std::function<bool(const TokenAvaiableData&, const TokenAvaiableData&)>;
+
+    /*
+        Type of the value a stage evaluates to, as far as it's known before evaluation.
+    */
+    enum class StageType : uint8_t {
+        UNKNOWN,
+        NIL,
+        BOOLEAN,
+        NUMERIC,
+        STRING,
+        ARRAY,
+        OBJECT,
+    };
 
     class EvaluationStage {
         public:
@@ -40,6 +57,21 @@ namespace Cvaluate {
             StageTypeCheck right_type_check_;
 
             StageCombinedTypeCheck type_check_;
+
+            // Payload of leaf stages, kept so the stage tree can be compiled:
+            // the literal value, the parameter name or the accessor names.
+            // Operators bound to their literal operand keep the literal here.
+            TokenAvaiableData value_;
+            ExpressionFunction function_;
+            // `function_` as it is called, with its arguments as a span.
+            VariadicFunction variadic_function_;
+
+            // Set by the type inference pass of the planner.
+            StageType type_ = StageType::UNKNOWN;
+
+            // Set by the common-subexpression pass on stages with several parents:
+            // where the stage's result is kept during one evaluation, or -1 if it isn't shared.
+            int shared_index_ = -1;
         public:
             EvaluationStage() = delete;
             EvaluationStage(OperatorSymbol symbol, std::shared_ptr<EvaluationStage> left_stage,
@@ -50,55 +82,87 @@ namespace Cvaluate {
                 type_check_(type_check) {};
             void SwapWith(std::shared_ptr<EvaluationStage> other);
             void SetToNonStage(EvaluationStage other);
-            bool IsShortCircuitable();
+            bool IsShortCircuitable() const;
     };
 
-    bool IsString(TokenAvaiableData& value);
-    bool IsBool(TokenAvaiableData& value);
-    bool IsNumeric(TokenAvaiableData& value);
-    bool IsFloat(TokenAvaiableData& value);
-    bool IsInt(TokenAvaiableData& value);
-    bool IsArray(TokenAvaiableData& value);
-    bool IsRegexOrString(TokenAvaiableData& value);
-    bool AdditionTypeCheck(TokenAvaiableData& left, TokenAvaiableData& right);
-    bool ComparatorTypeCheck(TokenAvaiableData& left, TokenAvaiableData& right);
+    bool IsString(const TokenAvaiableData& value);
+    bool IsBool(const TokenAvaiableData& value);
+    bool IsNumeric(const TokenAvaiableData& value);
+    bool IsFloat(const TokenAvaiableData& value);
+    bool IsInt(const TokenAvaiableData& value);
+    bool IsArray(const TokenAvaiableData& value);
+    bool IsRegexOrString(const TokenAvaiableData& value);
+    bool AdditionTypeCheck(const TokenAvaiableData& left, const TokenAvaiableData& right);
+    bool ComparatorTypeCheck(const TokenAvaiableData& left, const TokenAvaiableData& right);
 
     // Operator type
-    TokenAvaiableData AddStage(TokenAvaiableData, TokenAvaiableData, Parameters = {});
-    TokenAvaiableData SubtractStage(TokenAvaiableData, TokenAvaiableData, Parameters = {});
-    TokenAvaiableData MultiplyStage(TokenAvaiableData, TokenAvaiableData, Parameters = {});
-    TokenAvaiableData DivideStage(TokenAvaiableData, TokenAvaiableData, Parameters = {});
-    TokenAvaiableData ExponentStage(TokenAvaiableData, TokenAvaiableData, Parameters = {});
-    TokenAvaiableData ModulusStage(TokenAvaiableData, TokenAvaiableData, Parameters = {});
-    TokenAvaiableData GteStage(TokenAvaiableData, TokenAvaiableData, Parameters = {});
-    TokenAvaiableData GtStage(TokenAvaiableData, TokenAvaiableData, Parameters = {});
-    TokenAvaiableData LteStage(TokenAvaiableData, TokenAvaiableData, Parameters = {});
-    TokenAvaiableData LtStage(TokenAvaiableData, TokenAvaiableData, Parameters = {});
-    TokenAvaiableData EqualStage(TokenAvaiableData, TokenAvaiableData, Parameters = {});
-    TokenAvaiableData NotEqualStage(TokenAvaiableData, TokenAvaiableData, Parameters = {});
-    TokenAvaiableData AndStage(TokenAvaiableData, TokenAvaiableData, Parameters = {});
-    TokenAvaiableData OrStage(TokenAvaiableData, TokenAvaiableData, Parameters = {});
-    TokenAvaiableData NegateStage(TokenAvaiableData, TokenAvaiableData, Parameters = {});
-    TokenAvaiableData InvertStage(TokenAvaiableData, TokenAvaiableData, Parameters = {});
-    TokenAvaiableData BitwiseNotStage(TokenAvaiableData, TokenAvaiableData, Parameters = {});
-    TokenAvaiableData TernaryIfStage(TokenAvaiableData, TokenAvaiableData, Parameters = {});
-    TokenAvaiableData TernaryElseStage(TokenAvaiableData, TokenAvaiableData, Parameters = {});
-    TokenAvaiableData RegexStage(TokenAvaiableData, TokenAvaiableData, Parameters = {});
-    TokenAvaiableData NotRegexStage(TokenAvaiableData, TokenAvaiableData, Parameters = {});
-    TokenAvaiableData BitwiseOrStage(TokenAvaiableData, TokenAvaiableData, Parameters = {});
-    TokenAvaiableData BitwiseAndStage(TokenAvaiableData, TokenAvaiableData, Parameters = {});
-    TokenAvaiableData BitwiseXORStage(TokenAvaiableData, TokenAvaiableData, Parameters = {});
-    TokenAvaiableData LeftShiftStage(TokenAvaiableData, TokenAvaiableData, Parameters = {});
-    TokenAvaiableData RightShiftStage(TokenAvaiableData, TokenAvaiableData, Parameters = {});
-
-    TokenAvaiableData NoopStageRight(TokenAvaiableData, TokenAvaiableData, Parameters);
-    TokenAvaiableData InStage(TokenAvaiableData, TokenAvaiableData, Parameters);
-    TokenAvaiableData SeparatorStage(TokenAvaiableData, TokenAvaiableData, Parameters);
-
-    EvaluationOperator MakeParameterStage(std::string parameter_name);
-    EvaluationOperator MakeLiteralStage(TokenAvaiableData);
-    EvaluationOperator MakeFunctionStage(ExpressionFunction);
-    EvaluationOperator MakeAccessorStage(TokenAvaiableData);
+    TokenAvaiableData AddStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData SubtractStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData MultiplyStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData DivideStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData ExponentStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData ModulusStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData GteStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData GtStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData LteStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData LtStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData EqualStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData NotEqualStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData AndStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData OrStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData NegateStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData InvertStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData BitwiseNotStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData TernaryIfStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData TernaryElseStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData RegexStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData NotRegexStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData BitwiseOrStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData BitwiseAndStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData BitwiseXORStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData LeftShiftStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData RightShiftStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+
+    TokenAvaiableData NoopStageRight(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters&);
+    TokenAvaiableData InStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters&);
+    TokenAvaiableData SeparatorStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters&);
+
+    // Operators specialized for operands of a known type, falling back to the generic operator otherwise.
+    TokenAvaiableData NumericAddStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData NumericGteStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData NumericGtStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData NumericLteStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData NumericLtStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData NumericEqualStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData NumericNotEqualStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData StringAddStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData StringEqualStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData StringNotEqualStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData BoolEqualStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+    TokenAvaiableData BoolNotEqualStage(const TokenAvaiableData&, const TokenAvaiableData&, const Parameters& = kEmptyParameters);
+
+    EvaluationOperator FindSpecializedStage(OperatorSymbol symbol, StageType left_type, StageType right_type);
+
+    EvaluationOperator MakeParameterStage(const std::string& parameter_name);
+    EvaluationOperator MakeLiteralStage(const TokenAvaiableData&);
+    EvaluationOperator MakeFunctionStage(const ExpressionFunction&);
+    EvaluationOperator MakeAccessorStage(const TokenAvaiableData&);
+    // Match against a pattern compiled once, instead of looking it up on every evaluation.
+    EvaluationOperator MakeRegexStage(const std::string& pattern, bool negate);
+    // Check membership in a literal array indexed once, instead of scanning it on every evaluation.
+    EvaluationOperator MakeMembershipStage(const TokenAvaiableData& elements);
+
+    bool ShortCircuitStage(OperatorSymbol symbol, const TokenAvaiableData& left, TokenAvaiableData& result);
+
+    // Stages of the arguments of a call, split by the separators on the left spine of [arguments].
+    std::vector<std::shared_ptr<EvaluationStage>> FindArgumentStages(const std::shared_ptr<EvaluationStage>& arguments);
+
+    // Results of the shared stages during one evaluation, filled the first time each is evaluated.
+    using SharedStageResults = std::vector<std::optional<TokenAvaiableData>>;
+
+    // Evaluate the planned stages under [stage] by walking them, [shared] starts with one empty result per shared stage.
+    TokenAvaiableData EvaluateStageTree(const EvaluationStage* stage, const Parameters& params, SharedStageResults& shared);
+
 } // Cvaluate
 
 
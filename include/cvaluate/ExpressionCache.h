@@ -0,0 +1,86 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef CVALUATE_EXPRESSION_CACHE
+#define CVALUATE_EXPRESSION_CACHE
+
+#include "./EvaluableExpression.h"
+#include "./LruCache.h"
+
+namespace Cvaluate {
+    /*
+        Functions shared by the expressions of a cache. The cache tells function sets apart by address,
+        so the same set must be passed again to hit expressions compiled with it.
+    */
+    using FunctionSet = std::shared_ptr<const ExpressionFunctionMap>;
+
+    using ExpressionCacheStatistics = CacheStatistics;
+
+    // Return [expression] with whitespace outside of string literals and escaped names collapsed, as the cache key.
+    std::string NormalizeExpression(const std::string& expression);
+
+    /*
+        Compiled expressions keyed by normalized text and function set, shared as handles to immutable expressions.
+        Expressions are compiled outside of the locks; a failing expression throws and isn't cached.
+    */
+    class ExpressionCache {
+        private:
+            struct Key {
+                std::string expression;
+                const ExpressionFunctionMap* functions;
+
+                bool operator==(const Key& other) const {
+                    return this->functions == other.functions && this->expression == other.expression;
+                }
+            };
+
+            struct KeyHash {
+                size_t operator()(const Key& key) const {
+                    return std::hash<std::string>()(key.expression) ^ (std::hash<const void*>()(key.functions) * 31);
+                }
+            };
+
+            struct CachedExpression {
+                // Keeps the function set alive, so its address can't be reused by another set while cached.
+                FunctionSet functions;
+                std::shared_ptr<const EvaluableExpression> expression;
+            };
+
+            ShardedLruCache<Key, CachedExpression, KeyHash> cache_;
+            EvaluationMode mode_;
+        public:
+            /**
+             * @param capacity Maximum number of cached expressions, split evenly between the shards.
+             * @param shards Number of independently locked shards.
+             * @param mode Evaluation mode set on every compiled expression.
+             */
+            explicit ExpressionCache(size_t capacity = 1024, size_t shards = 16, EvaluationMode mode = EvaluationMode::TREE_WALK);
+
+            /**
+             * Return the compiled [expression], compiling and caching it on a miss.
+             *
+             * @param expression Expression text.
+             * @param functions Functions the expression may call, or nullptr for none.
+             */
+            std::shared_ptr<const EvaluableExpression> Get(const std::string& expression, const FunctionSet& functions = nullptr);
+
+            ExpressionCacheStatistics Statistics() const;
+
+            void Clear();
+    };
+} // Cvaluate
+
+#endif
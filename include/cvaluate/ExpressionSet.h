@@ -0,0 +1,69 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef CVALUATE_EXPRESSION_SET
+#define CVALUATE_EXPRESSION_SET
+
+#include "./Parising.h"
+#include "./StagePlanner.h"
+
+namespace Cvaluate {
+    /*
+        Many expressions planned into one DAG: subtrees repeated within or across the expressions are merged,
+        so evaluating the set over one parameter set computes each of them once.
+        Like `EvaluableExpression`, the set is read only once constructed and can be evaluated from many threads.
+    */
+    class ExpressionSet {
+        private:
+            std::vector<std::string> inputs_;
+            std::vector<std::shared_ptr<EvaluationStage>> stages_;
+            size_t eliminated_stages_ = 0;
+            size_t shared_stages_ = 0;
+        public:
+            /**
+             * @param expressions Expressions of the set, indexed by their position.
+             * @param functions Functions the expressions may call.
+             * @param schema Declared types of parameters, shared by the expressions.
+             */
+            explicit ExpressionSet(const std::vector<std::string>& expressions, const ExpressionFunctionMap& functions = {},
+                const ParameterSchema& schema = {});
+
+            size_t Size() const;
+
+            const std::string& Expression(size_t index) const;
+
+            // Stages removed by merging repeated subtrees, within and across the expressions.
+            size_t EliminatedStages() const;
+
+            /**
+             * Evaluate every expression, in one pass sharing the merged subtrees.
+             *
+             * @param parameters Parameters of all the expressions.
+             */
+            std::vector<TokenAvaiableData> Evaluate(const Parameters& parameters) const;
+
+            /**
+             * Evaluate only the expressions at [indices], returning their results in the same order.
+             * Subtrees are still shared, but only between the requested expressions.
+             *
+             * @param parameters Parameters of all the expressions.
+             * @param indices Positions of the expressions to evaluate.
+             */
+            std::vector<TokenAvaiableData> Evaluate(const Parameters& parameters, const std::vector<size_t>& indices) const;
+    };
+} // Cvaluate
+
+#endif
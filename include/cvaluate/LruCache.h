@@ -0,0 +1,136 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef CVALUATE_LRU_CACHE
+#define CVALUATE_LRU_CACHE
+
+#include "./pch.h"
+#include "./Exception.h"
+
+#include <list>
+
+namespace Cvaluate {
+    struct CacheStatistics {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+        size_t size = 0;
+    };
+
+    /*
+        A bounded map evicting its least recently used entries.
+        Keys are spread over shards, each with its own lock, list and counters,
+        so lookups of different keys rarely wait on each other and never share a written cache line.
+    */
+    template <typename Key, typename Value, typename Hash = std::hash<Key>>
+    class ShardedLruCache {
+        private:
+            using Entries = std::list<std::pair<Key, Value>>;
+
+            struct Shard {
+                std::mutex mutex;
+                // Most recently used first.
+                Entries entries;
+                std::unordered_map<Key, typename Entries::iterator, Hash> index;
+                size_t hits = 0;
+                size_t misses = 0;
+                size_t evictions = 0;
+            };
+
+            std::vector<std::unique_ptr<Shard>> shards_;
+            size_t shard_capacity_;
+        public:
+            ShardedLruCache(size_t capacity, size_t shards) {
+                if (capacity == 0 || shards == 0) {
+                    throw CvaluateException("Cache needs a positive capacity and shard count");
+                }
+
+                shards = std::min(shards, capacity);
+                this->shard_capacity_ = (capacity + shards - 1) / shards;
+
+                for (size_t i = 0; i < shards; i++) {
+                    this->shards_.push_back(std::make_unique<Shard>());
+                }
+            }
+
+            /*
+                Return the value cached for [key], or the result of [create] cached.
+                [create] runs outside of the locks; if it throws, nothing is cached.
+            */
+            template <typename Create>
+            Value GetOrCreate(const Key& key, Create create) {
+                auto& shard = *this->shards_[Hash()(key) % this->shards_.size()];
+
+                {
+                    std::lock_guard<std::mutex> lock(shard.mutex);
+                    auto entry = shard.index.find(key);
+
+                    if (entry != shard.index.end()) {
+                        shard.hits++;
+                        shard.entries.splice(shard.entries.begin(), shard.entries, entry->second);
+                        return entry->second->second;
+                    }
+
+                    shard.misses++;
+                }
+
+                Value value = create();
+
+                std::lock_guard<std::mutex> lock(shard.mutex);
+
+                // another thread may have created the same value meanwhile, keep a single copy.
+                auto entry = shard.index.find(key);
+                if (entry != shard.index.end()) {
+                    return entry->second->second;
+                }
+
+                shard.entries.emplace_front(key, value);
+                shard.index.emplace(key, shard.entries.begin());
+
+                if (shard.entries.size() > this->shard_capacity_) {
+                    shard.index.erase(shard.entries.back().first);
+                    shard.entries.pop_back();
+                    shard.evictions++;
+                }
+
+                return value;
+            }
+
+            CacheStatistics Statistics() const {
+                CacheStatistics ret;
+
+                for (auto& shard: this->shards_) {
+                    std::lock_guard<std::mutex> lock(shard->mutex);
+                    ret.hits += shard->hits;
+                    ret.misses += shard->misses;
+                    ret.evictions += shard->evictions;
+                    ret.size += shard->entries.size();
+                }
+
+                return ret;
+            }
+
+            void Clear() {
+                for (auto& shard: this->shards_) {
+                    std::lock_guard<std::mutex> lock(shard->mutex);
+                    shard->index.clear();
+                    shard->entries.clear();
+                }
+            }
+    };
+} // Cvaluate
+
+#endif
@@ -0,0 +1,93 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef CVALUATE_MATCH_NETWORK
+#define CVALUATE_MATCH_NETWORK
+
+#include <map>
+
+#include "./Parising.h"
+#include "./StagePlanner.h"
+
+namespace Cvaluate {
+    /*
+        Long-lived expressions matched incrementally against facts that change a few fields at a time.
+        The expressions are merged like an `ExpressionSet` and every stage keeps its result between updates.
+        Variables and accessors index the stages reading them by their path, like `r` or `r.env.hour`,
+        so an update only computes again the stages above the paths it touched and reports the expressions
+        whose result changed.
+        An expression that can't be evaluated, like one reading a fact that isn't set yet, has a null result.
+        Function calls are kept like any other stage, so they must only depend on their arguments.
+        The network isn't thread safe.
+    */
+    class MatchNetwork {
+        public:
+            struct MatchChange {
+                size_t expression;
+                TokenAvaiableData previous;
+                TokenAvaiableData current;
+            };
+        private:
+            std::vector<std::shared_ptr<EvaluationStage>> stages_;
+            std::vector<TokenAvaiableData> results_;
+            Parameters facts_;
+
+            // Kept result of each stage, empty until it is evaluated again.
+            SharedStageResults kept_;
+            std::vector<std::vector<int>> parents_;
+            // Path of the facts read by variables and accessors, to the stages reading them.
+            std::map<std::string, std::vector<int>> readers_;
+
+            void Invalidate(int stage);
+            void Invalidate(const std::string& path);
+            std::vector<MatchChange> Propagate();
+        public:
+            /**
+             * @param expressions Expressions of the network, indexed by their position.
+             * @param facts Facts the expressions are first evaluated with.
+             * @param functions Functions the expressions may call.
+             * @param schema Declared types of parameters, shared by the expressions.
+             */
+            explicit MatchNetwork(const std::vector<std::string>& expressions, Parameters facts = {},
+                const ExpressionFunctionMap& functions = {}, const ParameterSchema& schema = {});
+
+            size_t Size() const;
+
+            const std::vector<TokenAvaiableData>& Results() const;
+
+            const Parameters& Facts() const;
+
+            /**
+             * Set the fact at [path], a variable name or a dotted path into a variable like `r.env.hour`.
+             * Objects missing along the path are created.
+             *
+             * @param path Path of the fact.
+             * @param value New value of the fact.
+             * @return The expressions whose result changed.
+             */
+            std::vector<MatchChange> Update(const std::string& path, TokenAvaiableData value);
+
+            /**
+             * Remove the fact at [path], a variable or a field of a variable.
+             *
+             * @param path Path of the fact.
+             * @return The expressions whose result changed.
+             */
+            std::vector<MatchChange> Retract(const std::string& path);
+    };
+} // Cvaluate
+
+#endif
@@ -0,0 +1,57 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef CVALUATE_MEMBERSHIP_SET
+#define CVALUATE_MEMBERSHIP_SET
+
+#include "./Token.h"
+
+#include <unordered_set>
+
+namespace Cvaluate {
+    /*
+        The elements of a literal array, indexed for the `in` operator.
+        Elements are split by type and each type picks its container by size: short lists are scanned,
+        longer string lists are hashed and longer numeric lists are sorted for a binary search.
+        Membership is the same as comparing with `==`, so 1 and 1.0 are the same element and numbers are compared as floats.
+    */
+    class MembershipSet {
+        private:
+            // Below this many elements, a linear scan beats hashing or a binary search.
+            static constexpr size_t kScanLimit = 8;
+
+            std::vector<std::string> strings_;
+            std::unordered_set<std::string> hashed_strings_;
+            std::vector<float> numbers_;
+            bool sorted_numbers_ = false;
+            bool has_true_ = false;
+            bool has_false_ = false;
+            bool has_null_ = false;
+            // Arrays and objects, compared one by one.
+            std::vector<TokenAvaiableData> others_;
+            size_t size_ = 0;
+        public:
+            explicit MembershipSet(const TokenAvaiableData& elements);
+
+            bool Contains(const TokenAvaiableData& value) const;
+
+            size_t Size() const {
+                return this->size_;
+            }
+    };
+} // Cvaluate
+
+#endif
@@ -0,0 +1,56 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef CVALUATE_PARAMETER_FRAME
+#define CVALUATE_PARAMETER_FRAME
+
+#include "./Token.h"
+
+namespace Cvaluate {
+    /*
+        Parameters bound by slot instead of by name.
+        Slots are assigned when an expression is compiled, each variable name gets one.
+        The frame only borrows the bound values, they must outlive every evaluation using the frame.
+    */
+    class ParameterFrame {
+        private:
+            std::vector<const TokenAvaiableData*> values_;
+        public:
+            explicit ParameterFrame(size_t size) : values_(size, nullptr) {};
+
+            void Bind(size_t slot, const TokenAvaiableData& value) {
+                this->values_[slot] = &value;
+            }
+
+            // Binding a temporary would leave a dangling slot.
+            void Bind(size_t slot, TokenAvaiableData&& value) = delete;
+
+            void Unbind(size_t slot) {
+                this->values_[slot] = nullptr;
+            }
+
+            // Return the value bound to [slot], or nullptr if nothing is bound.
+            const TokenAvaiableData* Get(size_t slot) const {
+                return this->values_[slot];
+            }
+
+            size_t Size() const {
+                return this->values_.size();
+            }
+    };
+} // Cvaluate
+
+#endif
@@ -22,7 +22,7 @@
 #include "./OperatorSymbol.h"
 
 namespace Cvaluate {
-    std::vector<ExpressionToken> ParseTokens(std::string& expression, ExpressionFunctionMap& functions);
+    std::vector<ExpressionToken> ParseTokens(const std::string& expression, const ExpressionFunctionMap& functions);
     
     ExpressionToken Readtoken(std::stringstream& stream, TokenState& state, ExpressionFunctionMap functions);
     std::string ReadTokenUntilFalse(std::stringstream& stream, std::function<bool(char character)> condition);
@@ -0,0 +1,103 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef CVALUATE_RANGE_INDEX
+#define CVALUATE_RANGE_INDEX
+
+#include "./EvaluableExpression.h"
+
+namespace Cvaluate {
+    /*
+        Rules indexed by the numeric bounds they put on a variable, like `r.amount > 1000` or `r.risk < 0.3`.
+        Comparisons of a variable with a numeric literal at the top-level conjunction of a rule bound the variable,
+        the bounds of each rule on one variable are stored in an interval tree of that variable.
+        A parameter set finds the intervals containing its value by binary search,
+        and only the rules of those intervals and the rules without bounds are evaluated.
+        Rules excluded by their bounds are never evaluated, so an error another part of such a rule would raise,
+        like `s` not being a bool in `s && r.amount > 5`, is suppressed.
+    */
+    class RangeIndex {
+        private:
+            struct Interval {
+                float low;
+                bool low_strict;
+                float high;
+                bool high_strict;
+                size_t rule;
+
+                bool AboveLow(float value) const {
+                    return value > this->low || (value == this->low && !this->low_strict);
+                }
+
+                bool BelowHigh(float value) const {
+                    return value < this->high || (value == this->high && !this->high_strict);
+                }
+            };
+
+            /*
+                Node of a centered interval tree: the intervals containing the center, sorted by their low bound
+                and by their high bound, and the subtrees of the intervals entirely below and above the center.
+            */
+            struct IntervalNode {
+                float center;
+                std::vector<Interval> by_low;
+                std::vector<Interval> by_high;
+                int below = -1;
+                int above = -1;
+            };
+
+            struct IndexedVariable {
+                AccessorPath path;
+                std::vector<IntervalNode> nodes;
+                int root = -1;
+                // Every rule indexed by the variable, the candidates when the variable isn't a number.
+                std::vector<size_t> rules;
+            };
+
+            std::vector<std::shared_ptr<const EvaluableExpression>> rules_;
+            std::vector<IndexedVariable> variables_;
+            std::vector<size_t> unindexed_rules_;
+
+            static int BuildIntervalTree(std::vector<IntervalNode>& nodes, std::vector<Interval> intervals);
+            static void FindIntervals(const std::vector<IntervalNode>& nodes, int node, float value, std::vector<size_t>& rules);
+        public:
+            /**
+             * @param rules Expressions returning a bool, indexed by their position.
+             */
+            explicit RangeIndex(std::vector<std::shared_ptr<const EvaluableExpression>> rules);
+
+            size_t Size() const;
+
+            // Number of rules with a bound in the index.
+            size_t IndexedRules() const;
+
+            /**
+             * Return the positions of the rules that may be true for [parameters], in ascending order.
+             *
+             * @param parameters Parameters the rules are evaluated with.
+             */
+            std::vector<size_t> Candidates(const Parameters& parameters) const;
+
+            /**
+             * Return the positions of the rules that are true for [parameters], in ascending order.
+             *
+             * @param parameters Parameters the rules are evaluated with.
+             */
+            std::vector<size_t> Match(const Parameters& parameters) const;
+    };
+} // Cvaluate
+
+#endif
@@ -0,0 +1,52 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef CVALUATE_REGEX_CACHE
+#define CVALUATE_REGEX_CACHE
+
+#include "./LruCache.h"
+
+#include <regex>
+
+namespace Cvaluate {
+    /*
+        Compiled regular expressions keyed by pattern, using the ECMAScript syntax of std::regex.
+        Literal patterns are compiled once when an expression is parsed; patterns only known at evaluation-time,
+        like a parameter on the right of `=~`, are looked up here on every evaluation.
+    */
+    class RegexCache {
+        private:
+            ShardedLruCache<std::string, std::shared_ptr<const std::regex>> cache_;
+        public:
+            explicit RegexCache(size_t capacity = 256, size_t shards = 8) : cache_(capacity, shards) {};
+
+            // Return [pattern] compiled, throwing a CvaluateException if it isn't a valid regex.
+            std::shared_ptr<const std::regex> Get(const std::string& pattern);
+
+            CacheStatistics Statistics() const {
+                return this->cache_.Statistics();
+            }
+
+            void Clear() {
+                this->cache_.Clear();
+            }
+
+            // The cache used by `=~` and `!~`.
+            static RegexCache& Default();
+    };
+} // Cvaluate
+
+#endif
@@ -0,0 +1,80 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef CVALUATE_RULE_INDEX
+#define CVALUATE_RULE_INDEX
+
+#include "./EvaluableExpression.h"
+
+namespace Cvaluate {
+    /*
+        The rows of one variable, like the policy rows `p` of a matcher, indexed by the equality predicates of the expression.
+        Predicates `row.field == key` at the top-level conjunction of the expression, whose key doesn't depend on the row,
+        get a hash index from the value of the field to the rows having it.
+        Matching looks up the key of each predicate, keeps the smallest set of candidate rows
+        and evaluates the whole expression on those only.
+        Rows skipped by the index are the rows whose evaluation returns false, except that an error of the expression
+        is only raised by the candidate rows instead of the first row.
+    */
+    class RuleIndex {
+        private:
+            struct EqualityPredicate {
+                AccessorPath row_field;
+                // The other side of `==`, evaluated once per match.
+                const EvaluationStage* key;
+                std::unordered_map<std::string, std::vector<size_t>> rows;
+                // Rows whose field can't be hashed, like arrays and objects, which are always candidates.
+                std::vector<size_t> unindexed_rows;
+            };
+
+            std::shared_ptr<const EvaluableExpression> expression_;
+            std::string row_name_;
+            std::vector<TokenAvaiableData> rows_;
+            std::vector<EqualityPredicate> predicates_;
+            int row_slot_ = -1;
+
+            void AddPredicates(const EvaluationStage* stage);
+        public:
+            /**
+             * @param expression Expression evaluated for each row, returning a bool.
+             * @param row_name Variable the rows are bound to.
+             * @param rows Values of the variable, indexed by their position.
+             */
+            RuleIndex(std::shared_ptr<const EvaluableExpression> expression, const std::string& row_name,
+                std::vector<TokenAvaiableData> rows);
+
+            size_t Size() const;
+
+            // Number of equality predicates of the expression with an index.
+            size_t IndexedPredicates() const;
+
+            /**
+             * Return the positions of the rows the expression may be true for, in ascending order.
+             *
+             * @param parameters Variables of the expression other than the rows.
+             */
+            std::vector<size_t> Candidates(const Parameters& parameters) const;
+
+            /**
+             * Return the positions of the rows the expression is true for, in ascending order.
+             *
+             * @param parameters Variables of the expression other than the rows.
+             */
+            std::vector<size_t> Match(const Parameters& parameters) const;
+    };
+} // Cvaluate
+
+#endif
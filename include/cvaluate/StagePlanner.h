@@ -28,6 +28,10 @@ namespace Cvaluate {
     */
     using Precedent = std::function<std::shared_ptr<EvaluationStage>(TokenStream&)>;
 
+    /*
+        Plans one level of operator precedence. Planners are immutable once constructed,
+        so the shared planner chain can plan many expressions at once, from any number of threads.
+    */
     class PrecedencePlanner {
         public:
             const StringOperatorSymbolMap* valid_symbols = nullptr;
@@ -50,30 +54,11 @@ namespace Cvaluate {
                 this->next_right = other.next_right;
             };
 
-            std::shared_ptr<EvaluationStage> PlanPrecedenceLevel(TokenStream& stream,
-                const StringOperatorSymbolMap* vlaid_symbols, const std::vector<TokenKind>* valid_kinds,
-                Precedent& right_precedent, Precedent& left_precedent);
-
-            std::shared_ptr<EvaluationStage> operator()(TokenStream& stream) {
-                Precedent generated = nullptr;
-                Precedent* nextRight = &this->next_right;
+            // left precence > current, right precence >= current: without `next_right`, the right operand is planned at this level.
+            std::shared_ptr<EvaluationStage> PlanPrecedenceLevel(TokenStream& stream) const;
 
-                generated = [&] (TokenStream& stream) -> std::shared_ptr<EvaluationStage> {
-                    return PlanPrecedenceLevel(
-                        stream,
-                        this->valid_symbols,
-                        this->valid_kinds,
-                        *nextRight,
-                        this->next
-                    );
-                };
-
-                // left precence > current, right precence >= current
-                if (this->next_right == nullptr) {
-                    nextRight = &generated;
-                }                
-
-                return generated(stream);
+            std::shared_ptr<EvaluationStage> operator()(TokenStream& stream) const {
+                return this->PlanPrecedenceLevel(stream);
             }
     };
 
@@ -87,9 +72,34 @@ namespace Cvaluate {
         StageCombinedTypeCheck combined;
     };
     
-    std::shared_ptr<EvaluationStage> PlanStages(std::vector<ExpressionToken>& tokens);
+    /*
+        Counters filled by `PlanStages`, describing what the optimization passes did to the stage tree.
+    */
+    struct PlanStatistics {
+        size_t folded_stages = 0;
+        size_t specialized_stages = 0;
+        size_t eliminated_stages = 0;
+        // Stages evaluated once and reused by their other parents.
+        size_t shared_stages = 0;
+    };
+
+    /*
+        Declared types of parameters, keyed by variable name or by accessor chain like "foo.Nested.Funk".
+    */
+    using ParameterSchema = std::unordered_map<std::string, StageType>;
+
+    std::shared_ptr<EvaluationStage> PlanStages(std::vector<ExpressionToken>& tokens, PlanStatistics* statistics = nullptr,
+        const ParameterSchema& schema = {});
     std::shared_ptr<EvaluationStage> PlanTokens(TokenStream& stream);
     void RecorderStages(std::shared_ptr<EvaluationStage> root_stage);
+    size_t FoldConstantStages(std::shared_ptr<EvaluationStage>& stage);
+    void PrecompileLiteralOperands(const std::shared_ptr<EvaluationStage>& stage);
+    size_t CountStages(const std::shared_ptr<EvaluationStage>& stage);
+    size_t EliminateCommonStages(std::shared_ptr<EvaluationStage>& stage);
+    size_t EliminateCommonStages(std::vector<std::shared_ptr<EvaluationStage>>& roots);
+    size_t NumberSharedStages(const std::shared_ptr<EvaluationStage>& stage);
+    size_t NumberSharedStages(const std::vector<std::shared_ptr<EvaluationStage>>& roots);
+    size_t InferStageTypes(const std::shared_ptr<EvaluationStage>& stage, const ParameterSchema& schema);
 
     std::shared_ptr<EvaluationStage> PlanFunctions(TokenStream& stream);
     std::shared_ptr<EvaluationStage> PlanAccessor(TokenStream& stream);
@@ -0,0 +1,78 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef CVALUATE_THREAD_POOL
+#define CVALUATE_THREAD_POOL
+
+#include "./pch.h"
+
+#include <atomic>
+#include <deque>
+
+namespace Cvaluate {
+    /*
+        Runs tasks on threads owned by someone else, so parallel evaluation can share an application's threads.
+        Tasks must not throw.
+    */
+    class Executor {
+        public:
+            virtual ~Executor() {};
+
+            virtual void Submit(std::function<void()> task) = 0;
+
+            // Return the number of tasks that can run at once.
+            virtual size_t Concurrency() const = 0;
+    };
+
+    /*
+        A fixed set of workers with one task queue each.
+        Workers run their own queue newest first and, once it is empty, steal the oldest tasks of the other queues.
+        Tasks submitted from a worker go to its own queue, the others are spread round robin.
+    */
+    class ThreadPool : public Executor {
+        private:
+            struct WorkQueue {
+                std::mutex mutex;
+                std::deque<std::function<void()>> tasks;
+            };
+
+            std::vector<std::unique_ptr<WorkQueue>> queues_;
+            std::vector<std::thread> workers_;
+            std::mutex mutex_;
+            std::condition_variable wake_;
+            std::atomic<size_t> pending_{0};
+            std::atomic<size_t> next_queue_{0};
+            bool stopping_ = false;
+
+            bool TryRun(size_t index);
+            void Work(size_t index);
+        public:
+            explicit ThreadPool(size_t threads = std::thread::hardware_concurrency());
+            // Finish the queued tasks, then join the workers.
+            ~ThreadPool();
+
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
+
+            void Submit(std::function<void()> task) override;
+
+            size_t Concurrency() const override {
+                return this->workers_.size();
+            }
+    };
+} // Cvaluate
+
+#endif
@@ -17,6 +17,8 @@
 #ifndef CVALUATE_TOKEN
 #define CVALUATE_TOKEN
 
+#include <array>
+
 #include <nlohmann/json.hpp>
 
 #include "./pch.h"
@@ -26,6 +28,114 @@ namespace Cvaluate {
 
     using ExpressionFunction = std::function<TokenAvaiableData(TokenAvaiableData)>;
     using ExpressionFunctionMap = std::unordered_map<std::string, ExpressionFunction>;
+
+    /*
+        A function whose result only depends on its argument, so the planner may call it once for repeated calls.
+        Copies share the wrapped function, which identifies the function across the tokens calling it.
+    */
+    class PureFunction {
+        private:
+            std::shared_ptr<const ExpressionFunction> function_;
+        public:
+            explicit PureFunction(ExpressionFunction function) :
+                function_(std::make_shared<const ExpressionFunction>(std::move(function))) {};
+
+            TokenAvaiableData operator()(TokenAvaiableData argument) const {
+                return (*this->function_)(std::move(argument));
+            }
+
+            const void* Identity() const {
+                return this->function_.get();
+            }
+
+            const ExpressionFunction& Function() const {
+                return *this->function_;
+            }
+    };
+
+    // Mark [function] as pure, for registering in an `ExpressionFunctionMap`.
+    ExpressionFunction MakePureFunction(ExpressionFunction function);
+    // Return the identity of a function made by `MakePureFunction`, or nullptr for any other function.
+    const void* FindPureFunction(const ExpressionFunction& function);
+
+    /*
+        Arguments of a function call, a contiguous span of borrowed values only valid during the call.
+        Evaluation builds it in storage reused across calls, so calling a function allocates nothing for its arguments.
+    */
+    class FunctionArguments {
+        private:
+            const TokenAvaiableData* const* arguments_;
+            size_t size_;
+        public:
+            FunctionArguments(const TokenAvaiableData* const* arguments, size_t size) : arguments_(arguments), size_(size) {};
+
+            size_t size() const {
+                return this->size_;
+            }
+
+            bool empty() const {
+                return this->size_ == 0;
+            }
+
+            const TokenAvaiableData& operator[](size_t index) const {
+                return *this->arguments_[index];
+            }
+    };
+
+    using VariadicFunction = std::function<TokenAvaiableData(const FunctionArguments&)>;
+
+    /*
+        A function taking its arguments as `FunctionArguments`, registered as an `ExpressionFunction`.
+        Called with a single value like the other functions, an array is spread into the arguments,
+        null is no argument and any other value is the only argument.
+    */
+    class VariadicCall {
+        private:
+            std::shared_ptr<const VariadicFunction> function_;
+        public:
+            explicit VariadicCall(VariadicFunction function) :
+                function_(std::make_shared<const VariadicFunction>(std::move(function))) {};
+
+            TokenAvaiableData operator()(TokenAvaiableData argument) const;
+
+            const VariadicFunction& Function() const {
+                return *this->function_;
+            }
+    };
+
+    // Wrap [function] for registering in an `ExpressionFunctionMap`, it can be made pure as well.
+    ExpressionFunction MakeVariadicFunction(VariadicFunction function);
+    /*
+        Return how evaluation calls [function]: the function itself if it was made by `MakeVariadicFunction`,
+        otherwise an adapter packing the arguments into the single value the function takes,
+        the only argument as is or an array of them.
+    */
+    VariadicFunction FindVariadicFunction(const ExpressionFunction& function);
+
+    /*
+        Storage for the arguments of one call, inline for the usual few arguments.
+    */
+    template <typename T, size_t N = 8>
+    class ArgumentBuffer {
+        private:
+            std::array<T, N> inline_{};
+            std::vector<T> overflow_;
+            T* data_;
+        public:
+            explicit ArgumentBuffer(size_t size) : data_(inline_.data()) {
+                if (size > N) {
+                    this->overflow_.resize(size);
+                    this->data_ = this->overflow_.data();
+                }
+            }
+
+            ArgumentBuffer(const ArgumentBuffer&) = delete;
+            ArgumentBuffer& operator=(const ArgumentBuffer&) = delete;
+
+            T* Data() {
+                return this->data_;
+            }
+    };
     
     using TokenAvaiableValue = std::variant<
             TokenAvaiableData,
@@ -362,12 +472,12 @@ namespace Cvaluate {
         }
     };
 
-    std::string GetTokenValueString(TokenAvaiableData);
-    std::string GetTokenValueString(TokenAvaiableValue);
-    int GetTokenValueInt(TokenAvaiableData);
-    float GetTokenValueFloat(TokenAvaiableData);
-    float GetTokenValueNumeric(TokenAvaiableData);
-    bool GetTokenValueBool(TokenAvaiableData);
+    std::string GetTokenValueString(const TokenAvaiableData&);
+    std::string GetTokenValueString(const TokenAvaiableValue&);
+    int GetTokenValueInt(const TokenAvaiableData&);
+    float GetTokenValueFloat(const TokenAvaiableData&);
+    float GetTokenValueNumeric(const TokenAvaiableData&);
+    bool GetTokenValueBool(const TokenAvaiableData&);
     nlohmann::json GetTokenValueJson(TokenAvaiableValue);
     TokenAvaiableData GetTokenValueData(TokenAvaiableValue);
     ExpressionFunction GetTokenValueFunction(TokenAvaiableValue);
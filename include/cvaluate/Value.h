@@ -0,0 +1,129 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef CVALUATE_VALUE
+#define CVALUATE_VALUE
+
+#include <string_view>
+
+#include "./Token.h"
+
+namespace Cvaluate {
+    /*
+        Compact tagged value used on the stack of the `VirtualMachine` instead of `TokenAvaiableData`.
+        Booleans, numbers and strings of up to 8 bytes are stored inline.
+        Longer strings, objects and arrays are borrowed from the parameters, the program or a `ValueArena`,
+        which must outlive the value.
+        Numbers keep the semantics of the stage operators: they are read as float, and integers go through int.
+    */
+    class Value {
+        public:
+            enum class Type : uint8_t {
+                NIL,
+                BOOLEAN,
+                INTEGER,
+                FLOAT,
+                SHORT_STRING,
+                STRING,
+                JSON,
+            };
+        private:
+            union {
+                bool boolean_;
+                int64_t integer_;
+                double float_;
+                const char* string_;
+                const TokenAvaiableData* json_;
+                char chars_[8];
+            };
+            uint32_t size_ = 0;
+            Type type_ = Type::NIL;
+        public:
+            Value() : integer_(0) {};
+
+            static Value Boolean(bool value);
+            static Value Integer(int64_t value);
+            static Value Float(double value);
+            // Strings longer than 8 bytes are borrowed.
+            static Value String(std::string_view value);
+            // Scalars are copied, strings, objects and arrays are borrowed.
+            static Value Borrow(const TokenAvaiableData& value);
+
+            Type GetType() const {
+                return this->type_;
+            }
+
+            bool IsNull() const {
+                return this->type_ == Type::NIL;
+            }
+
+            bool IsBool() const {
+                return this->type_ == Type::BOOLEAN;
+            }
+
+            bool IsNumeric() const {
+                return this->type_ == Type::INTEGER || this->type_ == Type::FLOAT;
+            }
+
+            bool IsString() const {
+                return this->type_ == Type::SHORT_STRING || this->type_ == Type::STRING;
+            }
+
+            // Same conversions and errors as `GetTokenValueBool`, `GetTokenValueNumeric` and `GetTokenValueString`.
+            bool GetBool() const;
+            float GetNumeric() const;
+            std::string_view GetStringView() const;
+            void AppendString(std::string& output) const;
+
+            TokenAvaiableData ToJson() const;
+            // Like `ToJson`, reusing the storage of [target] for strings.
+            void AssignTo(TokenAvaiableData& target) const;
+
+            // Return the borrowed object or array, or nullptr for any other value.
+            const TokenAvaiableData* GetJson() const {
+                return this->type_ == Type::JSON ? this->json_ : nullptr;
+            }
+    };
+
+    static_assert(sizeof(Value) == 16, "Value should stay two words wide");
+
+    /*
+        Owns the strings and json values created while executing a program, so `Value`s can borrow them.
+        `Reset` makes the storage reusable without releasing it.
+        It also keeps the storage of the arguments of function calls, reused by every call.
+    */
+    class ValueArena {
+        private:
+            std::vector<std::unique_ptr<std::string>> strings_;
+            size_t used_strings_ = 0;
+            std::vector<std::unique_ptr<TokenAvaiableData>> values_;
+            size_t used_values_ = 0;
+            std::vector<TokenAvaiableData> arguments_;
+            std::vector<const TokenAvaiableData*> argument_pointers_;
+        public:
+            // Return an empty string owned by the arena.
+            std::string& NewString();
+
+            Value Store(TokenAvaiableData&& value);
+
+            // Borrow [values] as the arguments of a call, valid until the next call of `Arguments`.
+            FunctionArguments Arguments(const Value* values, size_t count);
+
+            void Reset();
+    };
+} // Cvaluate
+
+#endif
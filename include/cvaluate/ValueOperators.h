@@ -0,0 +1,183 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef CVALUATE_VALUE_OPERATORS
+#define CVALUATE_VALUE_OPERATORS
+
+#include <cmath>
+
+#include "./Value.h"
+
+namespace Cvaluate {
+    /*
+        Operators over `Value`s, shared by the compiled evaluation modes.
+        They mirror the stage operators of EvaluationStage.cpp, including their float arithmetic and errors.
+        They're defined here so the closure backend can inline them into its nodes.
+    */
+    inline bool StringOperands(const Value& left, const Value& right) {
+        return left.IsString() && right.IsString();
+    }
+
+    inline bool EqualValues(const Value& left, const Value& right) {
+        if (StringOperands(left, right)) {
+            return left.GetStringView() == right.GetStringView();
+        }
+
+        if (left.IsNumeric() && right.IsNumeric()) {
+            return left.GetNumeric() == right.GetNumeric();
+        }
+
+        if (left.IsBool() && right.IsBool()) {
+            return left.GetBool() == right.GetBool();
+        }
+
+        if (left.GetType() == Value::Type::JSON || right.GetType() == Value::Type::JSON) {
+            return left.ToJson() == right.ToJson();
+        }
+
+        // Scalars of different kinds, only two nulls are equal.
+        return left.IsNull() && right.IsNull();
+    }
+
+    struct AddOperator {
+        static Value Apply(const Value& left, const Value& right, ValueArena& arena) {
+            if (left.IsString() || right.IsString()) {
+                auto& ret = arena.NewString();
+                left.AppendString(ret);
+                right.AppendString(ret);
+                return Value::String(ret);
+            }
+
+            return Value::Float(left.GetNumeric() + right.GetNumeric());
+        }
+    };
+
+    struct SubtractOperator {
+        static Value Apply(const Value& left, const Value& right, ValueArena&) {
+            return Value::Float(left.GetNumeric() - right.GetNumeric());
+        }
+    };
+
+    struct MultiplyOperator {
+        static Value Apply(const Value& left, const Value& right, ValueArena&) {
+            return Value::Float(left.GetNumeric() * right.GetNumeric());
+        }
+    };
+
+    struct DivideOperator {
+        static Value Apply(const Value& left, const Value& right, ValueArena&) {
+            return Value::Float(left.GetNumeric() / right.GetNumeric());
+        }
+    };
+
+    struct ExponentOperator {
+        static Value Apply(const Value& left, const Value& right, ValueArena&) {
+            return Value::Float((float)pow(left.GetNumeric(), right.GetNumeric()));
+        }
+    };
+
+    struct ModulusOperator {
+        static Value Apply(const Value& left, const Value& right, ValueArena&) {
+            return Value::Float((float)((int)left.GetNumeric() % (int)right.GetNumeric()));
+        }
+    };
+
+    struct GteOperator {
+        static Value Apply(const Value& left, const Value& right, ValueArena&) {
+            if (StringOperands(left, right)) {
+                return Value::Boolean(left.GetStringView() >= right.GetStringView());
+            }
+            return Value::Boolean(left.GetNumeric() >= right.GetNumeric());
+        }
+    };
+
+    struct GtOperator {
+        static Value Apply(const Value& left, const Value& right, ValueArena&) {
+            if (StringOperands(left, right)) {
+                return Value::Boolean(left.GetStringView() > right.GetStringView());
+            }
+            return Value::Boolean(left.GetNumeric() > right.GetNumeric());
+        }
+    };
+
+    struct LteOperator {
+        static Value Apply(const Value& left, const Value& right, ValueArena&) {
+            if (StringOperands(left, right)) {
+                return Value::Boolean(left.GetStringView() <= right.GetStringView());
+            }
+            return Value::Boolean(left.GetNumeric() <= right.GetNumeric());
+        }
+    };
+
+    struct LtOperator {
+        static Value Apply(const Value& left, const Value& right, ValueArena&) {
+            if (StringOperands(left, right)) {
+                return Value::Boolean(left.GetStringView() < right.GetStringView());
+            }
+            return Value::Boolean(left.GetNumeric() < right.GetNumeric());
+        }
+    };
+
+    struct EqualOperator {
+        static Value Apply(const Value& left, const Value& right, ValueArena&) {
+            return Value::Boolean(EqualValues(left, right));
+        }
+    };
+
+    struct NotEqualOperator {
+        static Value Apply(const Value& left, const Value& right, ValueArena&) {
+            return Value::Boolean(!EqualValues(left, right));
+        }
+    };
+
+    struct AndOperator {
+        static Value Apply(const Value& left, const Value& right, ValueArena&) {
+            return Value::Boolean(left.GetBool() && right.GetBool());
+        }
+    };
+
+    struct OrOperator {
+        static Value Apply(const Value& left, const Value& right, ValueArena&) {
+            return Value::Boolean(left.GetBool() || right.GetBool());
+        }
+    };
+
+    struct TernaryIfOperator {
+        static Value Apply(const Value& left, const Value& right, ValueArena&) {
+            return left.GetBool() ? right : Value();
+        }
+    };
+
+    struct TernaryElseOperator {
+        static Value Apply(const Value& left, const Value& right, ValueArena&) {
+            return left.IsNull() ? right : left;
+        }
+    };
+
+    struct NegateOperator {
+        static Value Apply(const Value& right) {
+            return Value::Float(-right.GetNumeric());
+        }
+    };
+
+    struct InvertOperator {
+        static Value Apply(const Value& right) {
+            return Value::Boolean(!right.GetBool());
+        }
+    };
+} // Cvaluate
+
+#endif
@@ -17,5 +17,13 @@
 #define CVALUATE_H
 
 #include "./EvaluableExpression.h"
+#include "./ExpressionCache.h"
+#include "./ExpressionSet.h"
+#include "./RuleIndex.h"
+#include "./RangeIndex.h"
+#include "./DecisionDiagram.h"
+#include "./MatchNetwork.h"
+#include "./RegexCache.h"
+#include "./MembershipSet.h"
 
 #endif
\ No newline at end of file
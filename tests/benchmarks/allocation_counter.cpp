@@ -0,0 +1,98 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*
+* This file replaces the global allocation functions to count heap allocations.
+* It includes no benchmark headers, so the replacements are never inlined into their callers.
+*/
+
+#include "allocation_counter.h"
+
+#include <cstdlib>
+#include <algorithm>
+#include <new>
+
+static thread_local size_t allocation_count = 0;
+
+size_t AllocationCount() {
+    return allocation_count;
+}
+
+static void* Allocate(size_t size) {
+    allocation_count++;
+    if (void* pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+static void* AllocateAligned(size_t size, std::align_val_t alignment) {
+    allocation_count++;
+    auto align = static_cast<size_t>(alignment);
+    // aligned_alloc wants a size that is a multiple of the alignment.
+    size = (std::max<size_t>(size, 1) + align - 1) / align * align;
+    if (void* pointer = std::aligned_alloc(align, size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size) {
+    return Allocate(size);
+}
+
+void* operator new[](size_t size) {
+    return Allocate(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    return AllocateAligned(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+    return AllocateAligned(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept {
+    std::free(pointer);
+}
@@ -0,0 +1,28 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*
+* This is the allocation counter shared by the benchmarks
+*/
+
+#ifndef CVALUATE_BENCHMARK_ALLOCATION_COUNTER
+#define CVALUATE_BENCHMARK_ALLOCATION_COUNTER
+
+#include <cstddef>
+
+// Heap allocations made by the current thread so far, counted by the replaced global operator new.
+size_t AllocationCount();
+
+#endif
@@ -19,6 +19,26 @@
 #include <benchmark/benchmark.h>
 #include <cvaluate/cvaluate.h>
 #include "../test_config.h"
+#include "allocation_counter.h"
+
+/*
+    Reports the heap allocations made per iteration since construction as the "allocs" counter.
+*/
+class AllocationCounter {
+    private:
+        size_t start_ = AllocationCount();
+    public:
+        void Report(benchmark::State& state) {
+            state.counters["allocs"] = benchmark::Counter(double(AllocationCount() - this->start_),
+                benchmark::Counter::kAvgIterations);
+        }
+};
+
+// Runs an evaluation benchmark once per evaluation mode, so the modes are reported side by side.
+#define BENCHMARK_EVALUATION_MODES(func) \
+    BENCHMARK_CAPTURE(func, tree_walk, Cvaluate::EvaluationMode::TREE_WALK); \
+    BENCHMARK_CAPTURE(func, bytecode, Cvaluate::EvaluationMode::BYTECODE); \
+    BENCHMARK_CAPTURE(func, closure, Cvaluate::EvaluationMode::CLOSURE)
 
 static void BenchmarkSingleParse(benchmark::State& state) {
     for(auto _ : state)
@@ -34,6 +54,16 @@ static void BenchmarkSimpleParse(benchmark::State& state) {
 
 BENCHMARK(BenchmarkSimpleParse);
 
+static void BenchmarkCachedParse(benchmark::State& state) {
+    Cvaluate::ExpressionCache cache;
+    AllocationCounter allocations;
+    for(auto _ : state)
+        benchmark::DoNotOptimize(cache.Get("(requests_made * requests_succeeded / 100) >= 90"));
+    allocations.Report(state);
+}
+
+BENCHMARK(BenchmarkCachedParse);
+
 static void BenchmarkFullParse(benchmark::State& state) {
     std::string expression = std::string("2 > 1 &&") +
 		"\'something\' != \'nothing\' || " +
@@ -45,64 +75,100 @@ static void BenchmarkFullParse(benchmark::State& state) {
 
 BENCHMARK(BenchmarkFullParse);
 
-static void BenchmarkEvaluationSingle(benchmark::State& state) {
+static void BenchmarkEvaluationSingle(benchmark::State& state, Cvaluate::EvaluationMode mode) {
     auto expression = Cvaluate::EvaluableExpression("1");
+    expression.SetEvaluationMode(mode);
+    AllocationCounter allocations;
     for(auto _ : state)
         expression.Evaluate();
+    allocations.Report(state);
 }
 
-BENCHMARK(BenchmarkEvaluationSingle);
+BENCHMARK_EVALUATION_MODES(BenchmarkEvaluationSingle);
 
-static void BenchmarkEvaluationNumericLiteral(benchmark::State& state) {
+static void BenchmarkEvaluationNumericLiteral(benchmark::State& state, Cvaluate::EvaluationMode mode) {
     auto expression = Cvaluate::EvaluableExpression("(2) > (1)");
+    expression.SetEvaluationMode(mode);
+    AllocationCounter allocations;
     for(auto _ : state)
         expression.Evaluate();
+    allocations.Report(state);
 }
 
-BENCHMARK(BenchmarkEvaluationNumericLiteral);
+BENCHMARK_EVALUATION_MODES(BenchmarkEvaluationNumericLiteral);
 
-static void BenchmarkEvaluationLiteralModifiers(benchmark::State& state) {
+static void BenchmarkEvaluationLiteralModifiers(benchmark::State& state, Cvaluate::EvaluationMode mode) {
     auto expression = Cvaluate::EvaluableExpression("(2) + (2) == (4)");
+    expression.SetEvaluationMode(mode);
+    AllocationCounter allocations;
     for(auto _ : state)
         expression.Evaluate();
+    allocations.Report(state);
 }
 
-BENCHMARK(BenchmarkEvaluationLiteralModifiers);
+BENCHMARK_EVALUATION_MODES(BenchmarkEvaluationLiteralModifiers);
 
-static void BenchmarkEvaluationParameter(benchmark::State& state) {
+static void BenchmarkEvaluationParameter(benchmark::State& state, Cvaluate::EvaluationMode mode) {
     auto expression = Cvaluate::EvaluableExpression("requests_made");
+    expression.SetEvaluationMode(mode);
     auto parameters = Cvaluate::Parameters({
         {"requests_made", float(99.0)},
     });
+    AllocationCounter allocations;
     for(auto _ : state)
         expression.Evaluate(parameters);
+    allocations.Report(state);
 }
 
-BENCHMARK(BenchmarkEvaluationParameter);
+BENCHMARK_EVALUATION_MODES(BenchmarkEvaluationParameter);
 
-static void BenchmarkEvaluationParameters(benchmark::State& state) {
+static void BenchmarkEvaluationParameters(benchmark::State& state, Cvaluate::EvaluationMode mode) {
     auto expression = Cvaluate::EvaluableExpression("requests_made > requests_succeeded");
+    expression.SetEvaluationMode(mode);
     auto parameters = Cvaluate::Parameters({
         {"requests_made", float(99.0)},
         {"requests_succeeded", float(90.0)},
     });
+    AllocationCounter allocations;
     for(auto _ : state)
         expression.Evaluate(parameters);
+    allocations.Report(state);
 }
 
-BENCHMARK(BenchmarkEvaluationParameters);
+BENCHMARK_EVALUATION_MODES(BenchmarkEvaluationParameters);
 
-static void BenchmarkEvaluationParametersModifiers(benchmark::State& state) {
+static void BenchmarkEvaluationParametersModifiers(benchmark::State& state, Cvaluate::EvaluationMode mode) {
     auto expression = Cvaluate::EvaluableExpression("(requests_made * requests_succeeded / 100) >= 90");
+    expression.SetEvaluationMode(mode);
     auto parameters = Cvaluate::Parameters({
         {"requests_made", float(99.0)},
         {"requests_succeeded", float(90.0)},
     });
+    AllocationCounter allocations;
     for(auto _ : state)
         expression.Evaluate(parameters);
+    allocations.Report(state);
+}
+
+BENCHMARK_EVALUATION_MODES(BenchmarkEvaluationParametersModifiers);
+
+static void BenchmarkEvaluationParameterFrame(benchmark::State& state, Cvaluate::EvaluationMode mode) {
+    auto expression = Cvaluate::EvaluableExpression("(requests_made * requests_succeeded / 100) >= 90");
+    expression.SetEvaluationMode(mode);
+    Cvaluate::TokenAvaiableData requests_made = float(99.0);
+    Cvaluate::TokenAvaiableData requests_succeeded = float(90.0);
+    auto frame = expression.MakeParameterFrame();
+    frame.Bind(expression.FindParameterSlot("requests_made"), requests_made);
+    frame.Bind(expression.FindParameterSlot("requests_succeeded"), requests_succeeded);
+    AllocationCounter allocations;
+    for(auto _ : state)
+        expression.Evaluate(frame);
+    allocations.Report(state);
 }
 
-BENCHMARK(BenchmarkEvaluationParametersModifiers);
+// Frames are always evaluated by a compiled mode.
+BENCHMARK_CAPTURE(BenchmarkEvaluationParameterFrame, bytecode, Cvaluate::EvaluationMode::BYTECODE);
+BENCHMARK_CAPTURE(BenchmarkEvaluationParameterFrame, closure, Cvaluate::EvaluationMode::CLOSURE);
 
 // static void BenchmarkComplexExpression(benchmark::State& state) {
 //     std::string expressionString = std::string("2 > 1 &&") +
@@ -121,22 +187,439 @@ BENCHMARK(BenchmarkEvaluationParametersModifiers);
 
 // BENCHMARK(BenchmarkComplexExpression);
 
-static void BenchmarkAccessors(benchmark::State& state) {
+static void BenchmarkAccessors(benchmark::State& state, Cvaluate::EvaluationMode mode) {
     std::string expression_string = "foo.Int";
     auto expression = Cvaluate::EvaluableExpression(expression_string);
+    expression.SetEvaluationMode(mode);
     auto parameters = fooParameter;
+    AllocationCounter allocations;
     for(auto _ : state)
         expression.Evaluate(parameters);
+    allocations.Report(state);
 }
 
-BENCHMARK(BenchmarkAccessors);
+BENCHMARK_EVALUATION_MODES(BenchmarkAccessors);
 
-static void BenchmarkNestedAccessors(benchmark::State& state) {
+static void BenchmarkNestedAccessors(benchmark::State& state, Cvaluate::EvaluationMode mode) {
     std::string expression_string = "foo.Nested.Funk";
     auto expression = Cvaluate::EvaluableExpression(expression_string);
+    expression.SetEvaluationMode(mode);
     auto parameters = fooParameter;
+    AllocationCounter allocations;
+    for(auto _ : state)
+        expression.Evaluate(parameters);
+    allocations.Report(state);
+}
+
+BENCHMARK_EVALUATION_MODES(BenchmarkNestedAccessors);
+static void BenchmarkEvaluationBatch(benchmark::State& state, Cvaluate::EvaluationMode mode) {
+    auto expression = Cvaluate::EvaluableExpression("requests_made > requests_succeeded");
+    expression.SetEvaluationMode(mode);
+    std::vector<Cvaluate::Parameters> rows(state.range(0), Cvaluate::Parameters({
+        {"requests_made", float(99.0)},
+        {"requests_succeeded", float(90.0)},
+    }));
+    std::unique_ptr<bool[]> results(new bool[rows.size()]);
+    AllocationCounter allocations;
+    for(auto _ : state)
+        expression.EvaluateBatch(rows.data(), rows.size(), results.get());
+    allocations.Report(state);
+    // Time per row, next to the time per batch.
+    state.counters["per_row"] = benchmark::Counter(double(rows.size()),
+        benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+BENCHMARK_CAPTURE(BenchmarkEvaluationBatch, tree_walk, Cvaluate::EvaluationMode::TREE_WALK)->RangeMultiplier(10)->Range(1, 1000000);
+BENCHMARK_CAPTURE(BenchmarkEvaluationBatch, bytecode, Cvaluate::EvaluationMode::BYTECODE)->RangeMultiplier(10)->Range(1, 1000000);
+BENCHMARK_CAPTURE(BenchmarkEvaluationBatch, closure, Cvaluate::EvaluationMode::CLOSURE)->RangeMultiplier(10)->Range(1, 1000000);
+
+static void BenchmarkRegexLiteral(benchmark::State& state, Cvaluate::EvaluationMode mode) {
+    auto expression = Cvaluate::EvaluableExpression("foo =~ '^[fF][oO]+bar$'");
+    expression.SetEvaluationMode(mode);
+    Cvaluate::Parameters parameters = {{"foo", "foobar"}};
+    AllocationCounter allocations;
+    for(auto _ : state)
+        expression.Evaluate(parameters);
+    allocations.Report(state);
+}
+
+BENCHMARK_EVALUATION_MODES(BenchmarkRegexLiteral);
+
+// The pattern is a parameter, so it is looked up in the regex cache on every evaluation.
+static void BenchmarkRegexParameter(benchmark::State& state, Cvaluate::EvaluationMode mode) {
+    auto expression = Cvaluate::EvaluableExpression("foo =~ pattern");
+    expression.SetEvaluationMode(mode);
+    Cvaluate::Parameters parameters = {{"foo", "foobar"}, {"pattern", "^[fF][oO]+bar$"}};
+    AllocationCounter allocations;
+    for(auto _ : state)
+        expression.Evaluate(parameters);
+    allocations.Report(state);
+}
+
+BENCHMARK_EVALUATION_MODES(BenchmarkRegexParameter);
+
+// A generated matcher repeating the same call, which is only evaluated once when the function is pure.
+static void BenchmarkCommonSubexpressions(benchmark::State& state, bool pure) {
+    Cvaluate::ExpressionFunction key_match = [](Cvaluate::TokenAvaiableData arguments) {
+        auto& key = arguments[0].get_ref<const std::string&>();
+        auto& pattern = arguments[1].get_ref<const std::string&>();
+        return key.compare(0, pattern.size(), pattern) == 0;
+    };
+
+    auto expression = Cvaluate::EvaluableExpression(
+        "keyMatch(r.obj, p.obj) && r.act == 'read' || keyMatch(r.obj, p.obj) && r.act == 'write'",
+        {{"keyMatch", pure ? Cvaluate::MakePureFunction(key_match) : key_match}});
+    Cvaluate::Parameters parameters = {
+        {"r", {{"obj", "/data/reports/2021"}, {"act", "write"}}},
+        {"p", {{"obj", "/data/reports"}}},
+    };
+    AllocationCounter allocations;
     for(auto _ : state)
         expression.Evaluate(parameters);
+    allocations.Report(state);
+}
+
+BENCHMARK_CAPTURE(BenchmarkCommonSubexpressions, impure, false);
+BENCHMARK_CAPTURE(BenchmarkCommonSubexpressions, pure, true);
+
+// A call with two string arguments over a batch, with the arguments packed in an array or passed as a span.
+static void BenchmarkFunctionCall(benchmark::State& state, Cvaluate::EvaluationMode mode, bool variadic) {
+    Cvaluate::ExpressionFunction key_match = [](Cvaluate::TokenAvaiableData arguments) {
+        auto& key = arguments[0].get_ref<const std::string&>();
+        auto& pattern = arguments[1].get_ref<const std::string&>();
+        return key.compare(0, pattern.size(), pattern) == 0;
+    };
+    auto variadic_key_match = Cvaluate::MakeVariadicFunction([](const Cvaluate::FunctionArguments& arguments) {
+        auto& key = arguments[0].get_ref<const std::string&>();
+        auto& pattern = arguments[1].get_ref<const std::string&>();
+        return Cvaluate::TokenAvaiableData(key.compare(0, pattern.size(), pattern) == 0);
+    });
+
+    auto expression = Cvaluate::EvaluableExpression("keyMatch(r.obj, p.obj)",
+        {{"keyMatch", variadic ? variadic_key_match : key_match}});
+    expression.SetEvaluationMode(mode);
+    std::vector<Cvaluate::Parameters> rows(1000, Cvaluate::Parameters({
+        {"r", {{"obj", "/data/reports/2021"}}},
+        {"p", {{"obj", "/data/reports"}}},
+    }));
+    std::unique_ptr<bool[]> results(new bool[rows.size()]);
+    AllocationCounter allocations;
+    for(auto _ : state)
+        expression.EvaluateBatch(rows.data(), rows.size(), results.get());
+    allocations.Report(state);
+}
+
+BENCHMARK_CAPTURE(BenchmarkFunctionCall, tree_walk_packed, Cvaluate::EvaluationMode::TREE_WALK, false);
+BENCHMARK_CAPTURE(BenchmarkFunctionCall, tree_walk_variadic, Cvaluate::EvaluationMode::TREE_WALK, true);
+BENCHMARK_CAPTURE(BenchmarkFunctionCall, bytecode_packed, Cvaluate::EvaluationMode::BYTECODE, false);
+BENCHMARK_CAPTURE(BenchmarkFunctionCall, bytecode_variadic, Cvaluate::EvaluationMode::BYTECODE, true);
+BENCHMARK_CAPTURE(BenchmarkFunctionCall, closure_packed, Cvaluate::EvaluationMode::CLOSURE, false);
+BENCHMARK_CAPTURE(BenchmarkFunctionCall, closure_variadic, Cvaluate::EvaluationMode::CLOSURE, true);
+
+// Matchers, conditions and effects of one request, evaluated as separate expressions or as one set.
+static const std::vector<std::string> kRequestExpressions = {
+    "r.sub == p.sub && r.obj == p.obj && r.act == 'read'",
+    "r.sub == p.sub && r.obj == p.obj && r.act == 'write'",
+    "r.sub == p.sub && r.act == 'write' && r.env.ip != '127.0.0.1'",
+    "r.env.hour >= 9 && r.env.hour < 18",
+    "r.sub == p.sub && r.env.hour >= 9 ? 'allow' : 'deny'",
+};
+
+static const Cvaluate::Parameters kRequestParameters = {
+    {"r", {{"sub", "alice"}, {"obj", "data1"}, {"act", "write"}, {"env", {{"ip", "10.0.0.1"}, {"hour", 11}}}}},
+    {"p", {{"sub", "alice"}, {"obj", "data1"}}},
+};
+
+static void BenchmarkSeparateExpressions(benchmark::State& state) {
+    std::vector<Cvaluate::EvaluableExpression> expressions;
+    for (auto& input: kRequestExpressions) {
+        expressions.emplace_back(input);
+    }
+
+    for(auto _ : state)
+        for (auto& expression: expressions)
+            benchmark::DoNotOptimize(expression.Evaluate(kRequestParameters));
+}
+
+BENCHMARK(BenchmarkSeparateExpressions);
+
+static void BenchmarkExpressionSet(benchmark::State& state) {
+    Cvaluate::ExpressionSet set(kRequestExpressions);
+    for(auto _ : state)
+        benchmark::DoNotOptimize(set.Evaluate(kRequestParameters));
+}
+
+BENCHMARK(BenchmarkExpressionSet);
+
+// A casbin matcher over state.range(0) policy rows, evaluated on every row or on the candidates of the equality index.
+static std::vector<Cvaluate::TokenAvaiableData> MakePolicyRows(size_t count) {
+    std::vector<Cvaluate::TokenAvaiableData> rows;
+    for (size_t i = 0; i < count; i++) {
+        rows.push_back({{"sub", "user" + std::to_string(i % 1000)}, {"obj", "data" + std::to_string(i)}, {"act", "read"}});
+    }
+    return rows;
+}
+
+static const Cvaluate::Parameters kPolicyRequest = {{"r", {{"sub", "user42"}, {"obj", "data42"}, {"act", "read"}}}};
+
+static void BenchmarkPolicyScan(benchmark::State& state) {
+    auto rows = MakePolicyRows(state.range(0));
+    auto expression = Cvaluate::EvaluableExpression("r.sub == p.sub && r.obj == p.obj && r.act == p.act");
+    auto frame = expression.MakeParameterFrame();
+    Cvaluate::BindParameters(frame, expression.ParameterSlots(), kPolicyRequest);
+    auto row_slot = expression.FindParameterSlot("p");
+
+    for(auto _ : state) {
+        size_t matches = 0;
+        for (auto& row: rows) {
+            frame.Bind(row_slot, row);
+            matches += expression.Evaluate(frame) == true;
+        }
+        benchmark::DoNotOptimize(matches);
+    }
+}
+
+BENCHMARK(BenchmarkPolicyScan)->RangeMultiplier(10)->Range(1000, 100000);
+
+static void BenchmarkPolicyIndex(benchmark::State& state) {
+    auto expression = std::make_shared<Cvaluate::EvaluableExpression>("r.sub == p.sub && r.obj == p.obj && r.act == p.act");
+    Cvaluate::RuleIndex index(expression, "p", MakePolicyRows(state.range(0)));
+    for(auto _ : state)
+        benchmark::DoNotOptimize(index.Match(kPolicyRequest));
+}
+
+BENCHMARK(BenchmarkPolicyIndex)->RangeMultiplier(10)->Range(1000, 100000);
+
+// state.range(0) threshold rules differing only in their constants, evaluated one by one or through the range index.
+static std::vector<std::shared_ptr<const Cvaluate::EvaluableExpression>> MakeThresholdRules(size_t count) {
+    std::vector<std::shared_ptr<const Cvaluate::EvaluableExpression>> rules;
+    for (size_t i = 0; i < count; i++) {
+        rules.push_back(std::make_shared<Cvaluate::EvaluableExpression>(
+            "r.amount > " + std::to_string(i * 10) + " && r.amount <= " + std::to_string(i * 10 + 25) + " && r.risk < 0.3"));
+    }
+    return rules;
+}
+
+static const Cvaluate::Parameters kThresholdRequest = {{"r", {{"amount", 4242}, {"risk", 0.1}}}};
+
+static void BenchmarkThresholdScan(benchmark::State& state) {
+    auto rules = MakeThresholdRules(state.range(0));
+    for(auto _ : state) {
+        size_t matches = 0;
+        for (auto& rule: rules)
+            matches += rule->Evaluate(kThresholdRequest) == true;
+        benchmark::DoNotOptimize(matches);
+    }
+}
+
+BENCHMARK(BenchmarkThresholdScan)->RangeMultiplier(10)->Range(10, 10000);
+
+static void BenchmarkThresholdIndex(benchmark::State& state) {
+    Cvaluate::RangeIndex index(MakeThresholdRules(state.range(0)));
+    for(auto _ : state)
+        benchmark::DoNotOptimize(index.Match(kThresholdRequest));
+}
+
+BENCHMARK(BenchmarkThresholdIndex)->RangeMultiplier(10)->Range(10, 10000);
+
+// state.range(0) boolean rules drawn from a few shared predicates, evaluated as one set or through a decision diagram.
+static std::vector<std::string> MakeBooleanRules(size_t count) {
+    std::vector<std::string> rules;
+    for (size_t i = 0; i < count; i++) {
+        rules.push_back("(r.dept == 'd" + std::to_string(i % 8) + "' || r.role == 'admin') && r.level >= " +
+            std::to_string(i % 4) + " && !r.suspended");
+    }
+    return rules;
+}
+
+static const Cvaluate::Parameters kBooleanRulesRequest = {{"r", {{"dept", "d3"}, {"role", "user"}, {"level", 2}, {"suspended", false}}}};
+
+static void BenchmarkBooleanRulesSet(benchmark::State& state) {
+    Cvaluate::ExpressionSet set(MakeBooleanRules(state.range(0)));
+    for(auto _ : state)
+        benchmark::DoNotOptimize(set.Evaluate(kBooleanRulesRequest));
+}
+
+BENCHMARK(BenchmarkBooleanRulesSet)->RangeMultiplier(4)->Range(16, 1024);
+
+static void BenchmarkDecisionDiagram(benchmark::State& state) {
+    Cvaluate::DecisionDiagram diagram(MakeBooleanRules(state.range(0)));
+    for(auto _ : state)
+        benchmark::DoNotOptimize(diagram.Evaluate(kBooleanRulesRequest));
+}
+
+BENCHMARK(BenchmarkDecisionDiagram)->RangeMultiplier(4)->Range(16, 1024);
+
+// state.range(0) rules over 64 fields of one fact, one field changing between evaluations.
+static std::vector<std::string> MakeFactRules(size_t count) {
+    std::vector<std::string> rules;
+    for (size_t i = 0; i < count; i++) {
+        rules.push_back("r.f" + std::to_string(i % 64) + " > " + std::to_string(i % 10) + " && r.f" +
+            std::to_string((i + 1) % 64) + " != 'closed'");
+    }
+    return rules;
+}
+
+static Cvaluate::Parameters MakeFacts() {
+    Cvaluate::TokenAvaiableData fact;
+    for (int i = 0; i < 64; i++) {
+        fact["f" + std::to_string(i)] = i;
+    }
+    return {{"r", fact}};
+}
+
+static void BenchmarkFactUpdateSet(benchmark::State& state) {
+    Cvaluate::ExpressionSet set(MakeFactRules(state.range(0)));
+    auto facts = MakeFacts();
+    int value = 0;
+    for(auto _ : state) {
+        facts["r"]["f7"] = value++ % 10;
+        benchmark::DoNotOptimize(set.Evaluate(facts));
+    }
+}
+
+BENCHMARK(BenchmarkFactUpdateSet)->RangeMultiplier(4)->Range(64, 4096);
+
+static void BenchmarkFactUpdateNetwork(benchmark::State& state) {
+    Cvaluate::MatchNetwork network(MakeFactRules(state.range(0)), MakeFacts());
+    int value = 0;
+    for(auto _ : state)
+        benchmark::DoNotOptimize(network.Update("r.f7", value++ % 10));
+}
+
+BENCHMARK(BenchmarkFactUpdateNetwork)->RangeMultiplier(4)->Range(64, 4096);
+
+// Membership in a list of state.range(0) resource ids, written as a literal list or passed as an array parameter.
+static void BenchmarkMembership(benchmark::State& state, bool literal) {
+    std::string ids;
+    Cvaluate::TokenAvaiableData id_array = Cvaluate::TokenAvaiableData::array();
+    for (int i = 0; i < state.range(0); i++) {
+        ids += (ids.empty() ? "'resource" : ", 'resource") + std::to_string(i) + "'";
+        id_array.push_back("resource" + std::to_string(i));
+    }
+
+    auto expression = Cvaluate::EvaluableExpression(literal ? "r.obj in (" + ids + ")" : "r.obj in ids");
+    Cvaluate::Parameters parameters = {
+        {"r", {{"obj", "resource" + std::to_string(state.range(0) - 1)}}},
+        {"ids", id_array},
+    };
+    AllocationCounter allocations;
+    for(auto _ : state)
+        expression.Evaluate(parameters);
+    allocations.Report(state);
+}
+
+BENCHMARK_CAPTURE(BenchmarkMembership, literal, true)->RangeMultiplier(4)->Range(4, 1024);
+BENCHMARK_CAPTURE(BenchmarkMembership, parameter, false)->RangeMultiplier(4)->Range(4, 1024);
+
+// One expression per evaluation mode, constructed once and shared by every benchmark thread.
+static const Cvaluate::EvaluableExpression& SharedExpression(Cvaluate::EvaluationMode mode) {
+    static const auto expressions = [] {
+        std::vector<std::unique_ptr<Cvaluate::EvaluableExpression>> ret;
+        for (auto mode: {Cvaluate::EvaluationMode::TREE_WALK, Cvaluate::EvaluationMode::BYTECODE, Cvaluate::EvaluationMode::CLOSURE}) {
+            ret.push_back(std::make_unique<Cvaluate::EvaluableExpression>(
+                "(requests_made * requests_succeeded / 100) >= 90 && r.sub == 'alice'"));
+            ret.back()->SetEvaluationMode(mode);
+        }
+        return ret;
+    }();
+
+    return *expressions[static_cast<size_t>(mode)];
+}
+
+/*
+    Threads evaluating one shared expression with their own parameters.
+    Evaluation writes nothing shared, so the real time per evaluation should stay flat as threads are added
+    until they outnumber the cores.
+*/
+static void BenchmarkEvaluationSharedExpression(benchmark::State& state, Cvaluate::EvaluationMode mode) {
+    auto& expression = SharedExpression(mode);
+    Cvaluate::Parameters parameters = {
+        {"requests_made", float(99.0)},
+        {"requests_succeeded", float(90.0)},
+        {"r", {{"sub", "alice"}}},
+    };
+    for(auto _ : state)
+        benchmark::DoNotOptimize(expression.Evaluate(parameters));
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_CAPTURE(BenchmarkEvaluationSharedExpression, tree_walk, Cvaluate::EvaluationMode::TREE_WALK)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_CAPTURE(BenchmarkEvaluationSharedExpression, bytecode, Cvaluate::EvaluationMode::BYTECODE)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_CAPTURE(BenchmarkEvaluationSharedExpression, closure, Cvaluate::EvaluationMode::CLOSURE)->ThreadRange(1, 64)->UseRealTime();
+
+// Scaling of parallel batch evaluation with the number of pool threads, the calling thread helps as well.
+static void BenchmarkEvaluationBatchParallel(benchmark::State& state) {
+    auto expression = Cvaluate::EvaluableExpression("requests_made > requests_succeeded");
+    expression.SetEvaluationMode(Cvaluate::EvaluationMode::CLOSURE);
+    std::vector<Cvaluate::Parameters> rows(100000, Cvaluate::Parameters({
+        {"requests_made", float(99.0)},
+        {"requests_succeeded", float(90.0)},
+    }));
+    std::unique_ptr<bool[]> results(new bool[rows.size()]);
+    Cvaluate::ThreadPool pool(state.range(0));
+    for(auto _ : state)
+        expression.EvaluateBatchParallel(rows.data(), rows.size(), results.get(), pool);
+    state.counters["per_row"] = benchmark::Counter(double(rows.size()),
+        benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+BENCHMARK(BenchmarkEvaluationBatchParallel)->DenseRange(1, std::max(1u, std::thread::hardware_concurrency()))->UseRealTime();
+
+// Whether any of 100000 policy rows matches when the first match is at row state.range(0),
+// scanning the batch results or stopping at the match.
+static std::vector<Cvaluate::Parameters> MakeQuantifierRows(size_t match) {
+    std::vector<Cvaluate::Parameters> rows(100000, Cvaluate::Parameters({{"p", {{"sub", "bob"}}}, {"r", {{"sub", "alice"}}}}));
+    rows[match]["p"]["sub"] = "alice";
+    return rows;
+}
+
+static void BenchmarkQuantifierBatch(benchmark::State& state) {
+    auto expression = Cvaluate::EvaluableExpression("r.sub == p.sub");
+    expression.SetEvaluationMode(Cvaluate::EvaluationMode::CLOSURE);
+    auto rows = MakeQuantifierRows(state.range(0));
+    std::unique_ptr<bool[]> results(new bool[rows.size()]);
+    for(auto _ : state) {
+        expression.EvaluateBatch(rows.data(), rows.size(), results.get());
+        benchmark::DoNotOptimize(std::find(results.get(), results.get() + rows.size(), true));
+    }
+}
+
+BENCHMARK(BenchmarkQuantifierBatch)->RangeMultiplier(100)->Range(1, 99999);
+
+static void BenchmarkQuantifierAny(benchmark::State& state) {
+    auto expression = Cvaluate::EvaluableExpression("r.sub == p.sub");
+    expression.SetEvaluationMode(Cvaluate::EvaluationMode::CLOSURE);
+    auto rows = MakeQuantifierRows(state.range(0));
+    for(auto _ : state)
+        benchmark::DoNotOptimize(expression.EvaluateAny(rows.data(), rows.size()));
+}
+
+BENCHMARK(BenchmarkQuantifierAny)->RangeMultiplier(100)->Range(1, 99999);
+
+static void BenchmarkQuantifierAnyParallel(benchmark::State& state) {
+    auto expression = Cvaluate::EvaluableExpression("r.sub == p.sub");
+    expression.SetEvaluationMode(Cvaluate::EvaluationMode::CLOSURE);
+    auto rows = MakeQuantifierRows(state.range(0));
+    Cvaluate::ThreadPool pool(4);
+    for(auto _ : state)
+        benchmark::DoNotOptimize(expression.EvaluateAny(rows.data(), rows.size(), pool));
+}
+
+BENCHMARK(BenchmarkQuantifierAnyParallel)->RangeMultiplier(100)->Range(1, 99999)->UseRealTime();
+
+static void BenchmarkEvaluationColumns(benchmark::State& state, Cvaluate::SimdLevel level) {
+    auto expression = Cvaluate::EvaluableExpression("requests_made > requests_succeeded");
+    Cvaluate::ColumnBatch batch(state.range(0));
+    batch.Add("requests_made", Cvaluate::Column::Numeric(std::vector<float>(batch.Rows(), 99.0)));
+    batch.Add("requests_succeeded", Cvaluate::Column::Numeric(std::vector<float>(batch.Rows(), 90.0)));
+    AllocationCounter allocations;
+    for(auto _ : state)
+        benchmark::DoNotOptimize(expression.EvaluateColumns(batch, level));
+    allocations.Report(state);
+    state.counters["per_row"] = benchmark::Counter(double(batch.Rows()),
+        benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
 }
 
-BENCHMARK(BenchmarkNestedAccessors);
\ No newline at end of file
+BENCHMARK_CAPTURE(BenchmarkEvaluationColumns, scalar, Cvaluate::SimdLevel::SCALAR)->RangeMultiplier(10)->Range(1, 1000000);
+BENCHMARK_CAPTURE(BenchmarkEvaluationColumns, detected, Cvaluate::DetectSimdLevel())->RangeMultiplier(10)->Range(1, 1000000);
@@ -0,0 +1,146 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <cvaluate/EvaluableExpression.h>
+#include <cvaluate/Exception.h>
+
+namespace {
+
+const Cvaluate::SimdLevel kSimdLevels[] = {
+    Cvaluate::SimdLevel::SCALAR,
+    Cvaluate::SimdLevel::SSE4_2,
+    Cvaluate::SimdLevel::AVX2,
+    Cvaluate::SimdLevel::AVX512,
+};
+
+/*
+    A batch long enough to run the vector loops and their remainders, with a null in most columns.
+*/
+Cvaluate::ColumnBatch MakeBatch() {
+    const size_t rows = 67;
+    std::vector<float> numbers(rows), others(rows);
+    std::vector<uint8_t> booleans(rows);
+    std::vector<std::string> strings(rows);
+    Cvaluate::Bitmap number_nulls(rows), boolean_nulls(rows), string_nulls(rows);
+
+    for (size_t row = 0; row < rows; row++) {
+        numbers[row] = float(row % 13) - 4;
+        others[row] = float(row % 7);
+        booleans[row] = row % 3 == 0;
+        strings[row] = std::string(1, char('a' + row % 5));
+    }
+    number_nulls.Set(5, true);
+    boolean_nulls.Set(6, true);
+    boolean_nulls.Set(66, true);
+    string_nulls.Set(7, true);
+
+    Cvaluate::ColumnBatch batch(rows);
+    batch.Add("foo", Cvaluate::Column::Numeric(numbers, number_nulls));
+    batch.Add("bar", Cvaluate::Column::Numeric(others));
+    batch.Add("flag", Cvaluate::Column::Boolean(booleans, boolean_nulls));
+    batch.Add("name", Cvaluate::Column::String(strings, string_nulls));
+    batch.Add("r.sub", Cvaluate::Column::String(strings));
+    return batch;
+}
+
+TEST(TestColumnarEvaluation, TestMatchesRowEvaluation) {
+    std::vector<std::string> inputs = {
+        "foo",
+        "foo + bar * 2",
+        "foo - bar / 2",
+        "-foo",
+        "!flag",
+        "foo > bar",
+        "foo >= 1",
+        "1 < foo",
+        "foo <= bar",
+        "foo == bar",
+        "foo != 3",
+        "flag == true",
+        "name == 'c'",
+        "name != r.sub",
+        "name < 'c'",
+        "r.sub >= name",
+        "flag && foo > 0",
+        "flag || foo > 0",
+        "foo > 0 && flag",
+        "foo > 0 || flag",
+        "(foo > 0 && name == 'b') || !flag",
+        "flag && name > 0",
+        "foo + 'suffix'",
+        "flag ? foo : bar",
+        "name =~ 'a'",
+    };
+    auto batch = MakeBatch();
+
+    for (auto& input: inputs) {
+        auto expression = Cvaluate::EvaluableExpression(input);
+
+        for (auto level: kSimdLevels) {
+            auto results = expression.EvaluateColumns(batch, level);
+            ASSERT_EQ(results.Size(), batch.Rows()) << input;
+
+            for (size_t row = 0; row < batch.Rows(); row++) {
+                Cvaluate::TokenAvaiableData expected;
+                try {
+                    expected = expression.Evaluate(batch.GetRow(row));
+                } catch (const std::exception&) {
+                    expected = nullptr;
+                }
+
+                ASSERT_EQ(results.Get(row), expected) << input << " at row " << row;
+            }
+        }
+    }
+}
+
+TEST(TestColumnarEvaluation, TestMatches) {
+    auto batch = MakeBatch();
+    auto expression = Cvaluate::EvaluableExpression("foo > 0 && flag");
+    auto matches = expression.EvaluateColumns(batch).Matches();
+
+    ASSERT_EQ(matches.Size(), batch.Rows());
+    for (size_t row = 0; row < batch.Rows(); row++) {
+        auto foo = batch.Find("foo");
+        auto flag = batch.Find("flag");
+        bool expected = !foo->IsNull(row) && !flag->IsNull(row) && foo->Numbers()[row] > 0 && flag->Booleans()[row];
+        ASSERT_EQ(matches.Get(row), expected) << row;
+    }
+
+    ASSERT_THROW(expression.EvaluateColumns(Cvaluate::ColumnBatch(batch.Rows())), Cvaluate::CvaluateException);
+    ASSERT_THROW(Cvaluate::EvaluableExpression("foo + 1").EvaluateColumns(batch).Matches(), Cvaluate::CvaluateException);
+}
+
+TEST(TestColumnarEvaluation, TestColumnBatch) {
+    Cvaluate::ColumnBatch batch(2);
+    batch.Add("r.sub.name", Cvaluate::Column::String({"alice", "bob"}));
+    batch.Add("r.obj", Cvaluate::Column::Numeric({1, 2}, Cvaluate::Bitmap(2, true)));
+
+    auto row = batch.GetRow(1);
+    ASSERT_EQ(row["r"]["sub"]["name"], "bob");
+    ASSERT_TRUE(row["r"]["obj"].is_null());
+
+    ASSERT_THROW(batch.Add("foo", Cvaluate::Column::Numeric({1})), Cvaluate::CvaluateException);
+    ASSERT_THROW(Cvaluate::Column::Numeric({1}, Cvaluate::Bitmap(2)), Cvaluate::CvaluateException);
+
+    Cvaluate::Bitmap bitmap(70, true);
+    ASSERT_EQ(bitmap.Count(), 70);
+    bitmap.Set(69, false);
+    ASSERT_EQ(bitmap.Count(), 69);
+    ASSERT_FALSE(bitmap.Get(69));
+}
+
+} // namespace
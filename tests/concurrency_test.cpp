@@ -0,0 +1,121 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <cvaluate/EvaluableExpression.h>
+#include <cvaluate/Exception.h>
+
+/*
+    Stress tests for the thread safety of compilation and evaluation.
+    They only check results on their own, build with -DCVALUATE_SANITIZE_THREAD=ON to catch the races.
+*/
+namespace {
+
+const std::vector<std::string> kExpressions = {
+    "requests_made * requests_succeeded / 100 >= 90",
+    "(foo > 1 && bar.baz == 'qux') || !flag",
+    "flag ? 'yes' : 'no'",
+    "-foo + 2 ** 3 % 5",
+    "strlen(bar.baz) > 2 ?? 'fallback'",
+    "foo % 2 == 1 && bar.baz != 'x'",
+    "'a' + 'b' != 'ab' && 1 < 2",
+};
+
+const size_t kThreads = 8;
+
+Cvaluate::ExpressionFunctionMap MakeFunctions() {
+    Cvaluate::ExpressionFunctionMap functions;
+    functions["strlen"] = [](Cvaluate::TokenAvaiableData arguments) -> Cvaluate::TokenAvaiableData {
+        return float(arguments.get<std::string>().size());
+    };
+    return functions;
+}
+
+TEST(TestConcurrency, TestConcurrentCompilation) {
+    auto functions = MakeFunctions();
+    std::vector<size_t> expected;
+    for (auto& input: kExpressions) {
+        expected.push_back(Cvaluate::EvaluableExpression(input, functions).Tokens().size());
+    }
+
+    std::vector<std::vector<size_t>> token_counts(kThreads);
+    std::vector<std::thread> threads;
+
+    for (size_t thread = 0; thread < kThreads; thread++) {
+        threads.emplace_back([thread, &functions, &token_counts] {
+            for (size_t i = 0; i < 500; i++) {
+                Cvaluate::EvaluableExpression expression(kExpressions[(thread + i) % kExpressions.size()], functions);
+                token_counts[thread].push_back(expression.Tokens().size());
+            }
+        });
+    }
+
+    for (auto& thread: threads) {
+        thread.join();
+    }
+
+    for (size_t thread = 0; thread < kThreads; thread++) {
+        ASSERT_EQ(token_counts[thread].size(), 500);
+        for (size_t i = 0; i < token_counts[thread].size(); i++) {
+            ASSERT_EQ(token_counts[thread][i], expected[(thread + i) % kExpressions.size()]);
+        }
+    }
+}
+
+TEST(TestConcurrency, TestConcurrentEvaluation) {
+    auto functions = MakeFunctions();
+    Cvaluate::Parameters parameters = {
+        {"requests_made", 99},
+        {"requests_succeeded", 95},
+        {"foo", 3},
+        {"flag", true},
+        {"bar", {{"baz", "qux"}}},
+    };
+
+    for (auto mode: {Cvaluate::EvaluationMode::TREE_WALK, Cvaluate::EvaluationMode::BYTECODE, Cvaluate::EvaluationMode::CLOSURE}) {
+        std::vector<std::unique_ptr<Cvaluate::EvaluableExpression>> expressions;
+        std::vector<Cvaluate::TokenAvaiableData> expected;
+
+        for (auto& input: kExpressions) {
+            expressions.push_back(std::make_unique<Cvaluate::EvaluableExpression>(input, functions));
+            expressions.back()->SetEvaluationMode(mode);
+            expected.push_back(expressions.back()->Evaluate(parameters));
+        }
+
+        // Every thread evaluates the same shared expressions.
+        std::atomic<size_t> mismatches{0};
+        std::vector<std::thread> threads;
+
+        for (size_t thread = 0; thread < kThreads; thread++) {
+            threads.emplace_back([&] {
+                for (size_t i = 0; i < 200; i++) {
+                    for (size_t j = 0; j < expressions.size(); j++) {
+                        if (expressions[j]->Evaluate(parameters) != expected[j]) {
+                            mismatches++;
+                        }
+                    }
+                }
+            });
+        }
+
+        for (auto& thread: threads) {
+            thread.join();
+        }
+
+        ASSERT_EQ(mismatches, 0);
+    }
+}
+
+} // namespace
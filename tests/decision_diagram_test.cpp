@@ -0,0 +1,143 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <cvaluate/cvaluate.h>
+#include <cvaluate/Exception.h>
+
+namespace {
+
+TEST(TestDecisionDiagram, TestMatchesSeparateExpressions) {
+    std::vector<std::string> expressions = {
+        "a && b",
+        "a || b",
+        "!(a && b)",
+        "a && b || a && c",
+        "(a || b) && !(a || b)",
+        "c || true",
+        "x > 1 && (y == 'z' || !(x > 1))",
+        "a ? b : c",
+    };
+
+    Cvaluate::DecisionDiagram diagram(expressions);
+    ASSERT_EQ(diagram.Size(), expressions.size());
+
+    for (int combination = 0; combination < 16; combination++) {
+        Cvaluate::Parameters parameters = {
+            {"a", (combination & 1) != 0},
+            {"b", (combination & 2) != 0},
+            {"c", (combination & 4) != 0},
+            {"x", combination},
+            {"y", (combination & 8) ? "z" : "w"},
+        };
+
+        auto results = diagram.Evaluate(parameters);
+        ASSERT_EQ(results.size(), expressions.size());
+
+        for (size_t i = 0; i < expressions.size(); i++) {
+            auto expected = Cvaluate::EvaluableExpression(expressions[i]).Evaluate(parameters);
+            ASSERT_EQ(results[i], expected.get<bool>()) << expressions[i] << " " << combination;
+            ASSERT_EQ(diagram.Evaluate(parameters, i), expected.get<bool>()) << expressions[i] << " " << combination;
+        }
+    }
+}
+
+TEST(TestDecisionDiagram, TestReducedNodes) {
+    struct TestCase {
+        std::vector<std::string> expressions;
+        size_t predicates;
+        size_t nodes;
+    };
+
+    std::vector<TestCase> test_cases = {
+        {{"a && b", "b && a"}, 2, 2},
+        {{"a && b", "a || b"}, 2, 3},
+        {{"a && b || !a && !b"}, 2, 3},
+        {{"a || !a", "a && !a"}, 1, 0},
+        {{"a && b", "a && b && c", "a && b || a && b && c"}, 3, 5},
+        {{"x > 1 && (y == 'z' || !(x > 1))"}, 2, 2},
+    };
+
+    for (auto& test_case: test_cases) {
+        Cvaluate::DecisionDiagram diagram(test_case.expressions);
+        ASSERT_EQ(diagram.Predicates(), test_case.predicates) << test_case.expressions[0];
+        ASSERT_EQ(diagram.Nodes(), test_case.nodes) << test_case.expressions[0];
+    }
+}
+
+TEST(TestDecisionDiagram, TestPredicatesTestedOnce) {
+    int calls = 0;
+    Cvaluate::ExpressionFunctionMap functions = {
+        {"keyMatch", Cvaluate::MakePureFunction([&calls](Cvaluate::TokenAvaiableData arguments) {
+            calls++;
+            auto key = arguments[0].get<std::string>();
+            auto pattern = arguments[1].get<std::string>();
+            return key.compare(0, pattern.size(), pattern) == 0;
+        })},
+    };
+
+    Cvaluate::DecisionDiagram diagram({
+        "keyMatch(r.obj, p.obj) && r.act == 'read'",
+        "r.act == 'write' && keyMatch(r.obj, p.obj)",
+        "!keyMatch(r.obj, p.obj) || r.act == 'read'",
+    }, functions);
+    ASSERT_EQ(diagram.Predicates(), 3);
+
+    Cvaluate::Parameters parameters = {
+        {"r", {{"obj", "/data/reports"}, {"act", "write"}}},
+        {"p", {{"obj", "/data"}}},
+    };
+
+    ASSERT_EQ(diagram.Evaluate(parameters), std::vector<bool>({false, true, false}));
+    ASSERT_EQ(calls, 1);
+
+    // Tested results belong to one evaluation.
+    ASSERT_TRUE(diagram.Evaluate(parameters, 1));
+    ASSERT_EQ(calls, 2);
+}
+
+TEST(TestDecisionDiagram, TestErrors) {
+    Cvaluate::DecisionDiagram diagram({"foo + 1 && bar", "bar"});
+
+    ASSERT_THROW(diagram.Evaluate({{"foo", 1}, {"bar", true}}), Cvaluate::CvaluateException);
+    ASSERT_THROW(diagram.Evaluate({{"bar", true}}, 2), Cvaluate::CvaluateException);
+    ASSERT_FALSE(diagram.Evaluate({{"bar", false}}, 1));
+    ASSERT_THROW(Cvaluate::DecisionDiagram({"foo", ""}), Cvaluate::CvaluateException);
+
+    // `a` decides `b && a` before `b` is tested, so the error of `b` isn't raised.
+    Cvaluate::DecisionDiagram reordered({"a && b", "b && a"});
+    Cvaluate::Parameters parameters = {{"a", false}, {"b", 1}};
+    ASSERT_EQ(reordered.Evaluate(parameters), std::vector<bool>({false, false}));
+    ASSERT_THROW(Cvaluate::EvaluableExpression("b && a").Evaluate(parameters), Cvaluate::CvaluateException);
+}
+
+TEST(TestDecisionDiagram, TestNodeLimit) {
+    // Pairing the predicates of two chains doubles the nodes with every pair.
+    std::string xs, ys, pairs;
+    for (int i = 0; i < 8; i++) {
+        auto x = "x" + std::to_string(i);
+        auto y = "y" + std::to_string(i);
+        xs += (i == 0 ? "" : " && ") + x;
+        ys += (i == 0 ? "" : " && ") + y;
+        pairs += (i == 0 ? "(" : " || (") + x + " && " + y + ")";
+    }
+
+    ASSERT_GT(Cvaluate::DecisionDiagram({xs, ys, pairs}).Nodes(), 256);
+
+    ASSERT_THROW(Cvaluate::DecisionDiagram({xs, ys, pairs}, {}, {}, 256), Cvaluate::CvaluateException);
+    ASSERT_EQ(Cvaluate::DecisionDiagram({xs, ys}, {}, {}, 256).Nodes(), 16);
+}
+
+} // namespace
@@ -15,6 +15,9 @@
 */
 #include <gtest/gtest.h>
 #include <cvaluate/EvaluableExpression.h>
+#include <cvaluate/Exception.h>
+#include <cvaluate/RegexCache.h>
+#include <cvaluate/MembershipSet.h>
 #include "./test_config.h"
 
 namespace {
@@ -43,14 +46,37 @@ void Assert_Value(Cvaluate::TokenAvaiableData& expected, Cvaluate::TokenAvaiable
 
 }
 
+const std::vector<Cvaluate::EvaluationMode> kEvaluationModes = {
+    Cvaluate::EvaluationMode::TREE_WALK,
+    Cvaluate::EvaluationMode::BYTECODE,
+    Cvaluate::EvaluationMode::CLOSURE,
+};
+
 void RunEvaluationTests(std::vector<TokenEvaluationTest>& token_evaluation_tests) {
     for (auto& test_case: token_evaluation_tests) {
         auto expression = Cvaluate::EvaluableExpression(test_case.Input, test_case.Functions);
 
-        Cvaluate::Parameters parameters = test_case.Parameters;
-        auto result = expression.Evaluate(parameters);
+        // Every evaluation mode must agree on the result.
+        for (auto mode: kEvaluationModes) {
+            expression.SetEvaluationMode(mode);
+
+            Cvaluate::Parameters parameters = test_case.Parameters;
+            auto result = expression.Evaluate(parameters);
+
+            Assert_Value(test_case.Expected, result, test_case);
 
-        Assert_Value(test_case.Expected, result, test_case);
+            // Binding the same parameters by slot must agree as well.
+            auto frame = expression.MakeParameterFrame();
+            for (auto& parameter: test_case.Parameters) {
+                auto slot = expression.FindParameterSlot(parameter.first);
+                if (slot >= 0) {
+                    frame.Bind(slot, parameter.second);
+                }
+            }
+
+            auto frame_result = expression.Evaluate(frame);
+            Assert_Value(test_case.Expected, frame_result, test_case);
+        }
     }
 }
 
@@ -225,11 +251,12 @@ TEST(TestEvaluation, TestNoParameterEvaluation) {
 			float(16.0),
 		},
 
-		// EvaluationTest{
-		// 	Name:     "Null coalesce precedence",
-		// 	Input:    "true ?? true ? 100 + 200 : 400",
-		// 	Expected: 300.0,
-		// },
+		{
+
+			"Null coalesce precedence",
+			"true ?? true ? 100 + 200 : 400",
+			float(300),
+		},
 		// EvaluationTest{
 
 		// 	Name:     "Identical date equivalence",
@@ -332,84 +359,84 @@ TEST(TestEvaluation, TestNoParameterEvaluation) {
 			"10 * -10",
 			float(-100.0),
 		},
-		// EvaluationTest{
+		{
 
-		// 	Name:     "Ternary with single boolean",
-		// 	Input:    "true ? 10",
-		// 	Expected: 10.0,
-		// },
-		// EvaluationTest{
+			"Ternary with single boolean",
+			"true ? 10",
+			float(10),
+		},
+		{
 
-		// 	Name:     "Ternary nil with single boolean",
-		// 	Input:    "false ? 10",
-		// 	Expected: nil,
-		// },
-		// EvaluationTest{
+			"Ternary nil with single boolean",
+			"false ? 10",
+			nullptr,
+		},
+		{
 
-		// 	Name:     "Ternary with comparator boolean",
-		// 	Input:    "10 > 5 ? 35.50",
-		// 	Expected: 35.50,
-		// },
-		// EvaluationTest{
+			"Ternary with comparator boolean",
+			"10 > 5 ? 35.50",
+			float(35.5),
+		},
+		{
 
-		// 	Name:     "Ternary nil with comparator boolean",
-		// 	Input:    "1 > 5 ? 35.50",
-		// 	Expected: nil,
-		// },
-		// EvaluationTest{
+			"Ternary nil with comparator boolean",
+			"1 > 5 ? 35.50",
+			nullptr,
+		},
+		{
 
-		// 	Name:     "Ternary with parentheses",
-		// 	Input:    "(5 * (15 - 5)) > 5 ? 35.50",
-		// 	Expected: 35.50,
-		// },
-		// EvaluationTest{
+			"Ternary with parentheses",
+			"(5 * (15 - 5)) > 5 ? 35.50",
+			float(35.5),
+		},
+		{
 
-		// 	Name:     "Ternary precedence",
-		// 	Input:    "true ? 35.50 > 10",
-		// 	Expected: true,
-		// },
-		// EvaluationTest{
+			"Ternary precedence",
+			"true ? 35.50 > 10",
+			true,
+		},
+		{
 
-		// 	Name:     "Ternary-else",
-		// 	Input:    "false ? 35.50 : 50",
-		// 	Expected: 50.0,
-		// },
-		// EvaluationTest{
+			"Ternary-else",
+			"false ? 35.50 : 50",
+			float(50),
+		},
+		{
 
-		// 	Name:     "Ternary-else inside clause",
-		// 	Input:    "(false ? 5 : 35.50) > 10",
-		// 	Expected: true,
-		// },
-		// EvaluationTest{
+			"Ternary-else inside clause",
+			"(false ? 5 : 35.50) > 10",
+			true,
+		},
+		{
 
-		// 	Name:     "Ternary-else (true-case) inside clause",
-		// 	Input:    "(true ? 1 : 5) < 10",
-		// 	Expected: true,
-		// },
-		// EvaluationTest{
+			"Ternary-else (true-case) inside clause",
+			"(true ? 1 : 5) < 10",
+			true,
+		},
+		{
 
-		// 	Name:     "Ternary-else before comparator (negative case)",
-		// 	Input:    "true ? 1 : 5 > 10",
-		// 	Expected: 1.0,
-		// },
-		// EvaluationTest{
+			"Ternary-else before comparator (negative case)",
+			"true ? 1 : 5 > 10",
+			float(1),
+		},
+		{
 
-		// 	Name:     "Nested ternaries (#32)",
-		// 	Input:    "(2 == 2) ? 1 : (true ? 2 : 3)",
-		// 	Expected: 1.0,
-		// },
-		// EvaluationTest{
+			"Nested ternaries (#32)",
+			"(2 == 2) ? 1 : (true ? 2 : 3)",
+			float(1),
+		},
+		{
 
-		// 	Name:     "Nested ternaries, right case (#32)",
-		// 	Input:    "false ? 1 : (true ? 2 : 3)",
-		// 	Expected: 2.0,
-		// },
-		// EvaluationTest{
+			"Nested ternaries, right case (#32)",
+			"false ? 1 : (true ? 2 : 3)",
+			float(2),
+		},
+		{
 
-		// 	Name:     "Doubly-nested ternaries (#32)",
-		// 	Input:    "true ? (false ? 1 : (false ? 2 : 3)) : (false ? 4 : 5)",
-		// 	Expected: 3.0,
-		// },
+			"Doubly-nested ternaries (#32)",
+			"true ? (false ? 1 : (false ? 2 : 3)) : (false ? 4 : 5)",
+			float(3),
+		},
 		{
 
 			"String to string concat",
@@ -446,24 +473,30 @@ TEST(TestEvaluation, TestNoParameterEvaluation) {
 			"true + 'bar' == 'truebar'",
 			true,
 		},
-		// EvaluationTest{
+		{
 
-		// 	Name:     "Null coalesce left",
-		// 	Input:    "1 ?? 2",
-		// 	Expected: 1.0,
-		// },
-		// EvaluationTest{
+			"Null coalesce left",
+			"1 ?? 2",
+			float(1),
+		},
+		{
 
-		// 	Name:     "Array membership literals",
-		// 	Input:    "1 in (1, 2, 3)",
-		// 	Expected: true,
-		// },
-		// EvaluationTest{
+			"Array membership literals",
+			"1 in (1, 2, 3)",
+			true,
+		},
+		{
 
-		// 	Name:     "Array membership literal with inversion",
-		// 	Input:    "!(1 in (1, 2, 3))",
-		// 	Expected: false,
-		// },
+			"Array membership literal with inversion",
+			"!(1 in (1, 2, 3))",
+			false,
+		},
+		{
+
+			"Array membership of a missing literal",
+			"'d' in ('a', 'b', 'c')",
+			false,
+		},
 		{
 
 			"Logical operator reordering (#30)",
@@ -608,30 +641,34 @@ TEST(TestEvaluation, TestNoParameterEvaluation) {
 				},
 			},
 		},
-		// EvaluationTest{
-
-		// 	Name:  "Empty function ternary",
-		// 	Input: "nope() ? 1 : 2.0",
-		// 	Functions: map[string]ExpressionFunction{
-		// 		"nope": func(arguments ...interface{}) (interface{}, error) {
-		// 			return false, nil
-		// 		},
-		// 	},
-
-		// 	Expected: 2.0,
-		// },
-		// EvaluationTest{
+		{
 
-		// 	Name:  "Empty function null coalesce",
-		// 	Input: "null() ?? 2",
-		// 	Functions: map[string]ExpressionFunction{
-		// 		"null": func(arguments ...interface{}) (interface{}, error) {
-		// 			return nil, nil
-		// 		},
-		// 	},
+			"Empty function ternary",
+			"nope() ? 1 : 2.0",
+			float(2),
+			{
+				{
+                    "nope",
+                    [] (Cvaluate::TokenAvaiableData) -> Cvaluate::TokenAvaiableData {
+                        return false;
+                    }
+				},
+			},
+		},
+		{
 
-		// 	Expected: 2.0,
-		// },
+			"Empty function null coalesce",
+			"null() ?? 2",
+			float(2),
+			{
+				{
+                    "null",
+                    [] (Cvaluate::TokenAvaiableData) -> Cvaluate::TokenAvaiableData {
+                        return nullptr;
+                    }
+				},
+			},
+		},
 		{
 
 			"Empty function with prefix",
@@ -661,18 +698,20 @@ TEST(TestEvaluation, TestNoParameterEvaluation) {
 		// 		},
 		// 	},
 		// },
-		// EvaluationTest{
-
-		// 	Name:  "Empty function near separator",
-		// 	Input: "10 in (1, 2, 3, ten(), 8)",
-		// 	Functions: map[string]ExpressionFunction{
-		// 		"ten": func(arguments ...interface{}) (interface{}, error) {
-		// 			return 10.0, nil
-		// 		},
-		// 	},
+		{
 
-		// 	Expected: true,
-		// },
+			"Empty function near separator",
+			"10 in (1, 2, 3, ten(), 8)",
+			true,
+			{
+				{
+					"ten",
+					[] (Cvaluate::TokenAvaiableData data) -> Cvaluate::TokenAvaiableData {
+						return 10;
+					},
+				},
+			},
+		},
 		{
 
 			"Enclosed empty function with modifier and comparator (#28)",
@@ -687,17 +726,20 @@ TEST(TestEvaluation, TestNoParameterEvaluation) {
 				},
 			},
 		},
-		// EvaluationTest{
+		{
 
-		// 	Name:  "Ternary/Java EL ambiguity",
-		// 	Input: "false ? foo:length()",
-		// 	Functions: map[string]ExpressionFunction{
-		// 		"length": func(arguments ...interface{}) (interface{}, error) {
-		// 			return 1.0, nil
-		// 		},
-		// 	},
-		// 	Expected: 1.0,
-		// },
+			"Ternary/Java EL ambiguity",
+			"false ? foo:length()",
+			float(1),
+			{
+				{
+                    "length",
+                    [] (Cvaluate::TokenAvaiableData) -> Cvaluate::TokenAvaiableData {
+                        return float(1);
+                    }
+				},
+			},
+		},
 
     };
 
@@ -864,199 +906,215 @@ TEST(TestEvaluation, TestParameterizedEvaluation) {
 			},
 			
 		},
-		// {
-
-		// 	"Regex against right-hand parameter",
-		// 	"'foobar' =~ foo",
-		// 	{
-		// 		{
-		// 			"foo",
-		// 			"obar",
-		// 		},
-		// 	},
-		// 	true,
-		// },
-		// {
-
-		// 	"Not-regex against right-hand parameter",
-		// 	"'foobar' !~ foo",
-		// 	{
-		// 		{
-		// 			"foo",
-		// 			"baz",
-		// 		},
-		// 	},
-		// 	true,
-		// },
-		// {
-
-		// 	"Regex against two parameters",
-		// 	"foo =~ bar",
-		// 	{
-		// 		{
-		// 			"foo",
-		// 			"foobar",
-		// 		},
-		// 		{
-		// 			"bar",
-		// 			"oba",
-		// 		},
-		// 	},
-		// 	true,
-		// },
-		// {
-
-		// 	"Not-regex against two parameters",
-		// 	"foo !~ bar",
-		// 	{
-		// 		{
-		// 			"foo",
-		// 			"foobar",
-		// 		},
-		// 		{
-		// 			"bar",
-		// 			"baz",
-		// 		},
-		// 	},
-		// 	true,
-		// },
-		// {
-
-		// 	"Pre-compiled regex",
-		// 	"foo =~ bar",
-		// 	{
-		// 		{
-		// 			"foo",
-		// 			"foobar",
-		// 		},
-		// 		{
-		// 			"bar",
-		// 			regexp.MustCompile("[fF][oO]+"),
-		// 		},
-		// 	},
-		// 	true,
-		// },
-		// {
-
-		// 	"Pre-compiled not-regex",
-		// 	"foo !~ bar",
-		// 	{
-		// 		{
-		// 			"foo",
-		// 			"foobar",
-		// 		},
-		// 		{
-		// 			"bar",
-		// 			regexp.MustCompile("[fF][oO]+"),
-		// 		},
-		// 	},
-		// 	false,
-		// },
-		// {
-
-		// 	"Single boolean parameter",
-		// 	"commission ? 10",
-		// 	{
-		// 		{
-		// 			"commission",
-		// 			true,
-		// 		},
-		// 	},
-		// 	10.0,
-		// },
-		// {
-
-		// 	"True comparator with a parameter",
-		// 	"partner == 'amazon' ? 10",
-		// 	{
-		// 		{
-		// 			"partner",
-		// 			"amazon",
-		// 		},
-		// 	},
-		// 	10.0,
-		// },
-		// {
-
-		// 	"False comparator with a parameter",
-		// 	"partner == 'amazon' ? 10",
-		// 	{
-		// 		{
-		// 			"partner",
-		// 			"ebay",
-		// 		},
-		// 	},
-		// 	nil,
-		// },
-		// {
-
-		// 	"True comparator with multiple parameters",
-		// 	"theft && period == 24 ? 60",
-		// 	{
-		// 		{
-		// 			"theft",
-		// 			true,
-		// 		},
-		// 		{
-		// 			"period",
-		// 			24,
-		// 		},
-		// 	},
-		// 	60.0,
-		// },
-		// {
-
-		// 	"False comparator with multiple parameters",
-		// 	"theft && period == 24 ? 60",
-		// 	{
-		// 		{
-		// 			"theft",
-		// 			false,
-		// 		},
-		// 		{
-		// 			"period",
-		// 			24,
-		// 		},
-		// 	},
-		// 	nil,
-		// },
 		{
 
-			"String concat with single string parameter",
-			"foo + 'bar'",
-            "bazbar",
-            {},
+			"Regex against right-hand parameter",
+			"'foobar' =~ foo",
+			true,
+			{},
 			{
 				{
 					"foo",
-					"baz",
+					"obar",
 				},
 			},
-			
 		},
 		{
 
-			"String concat with multiple string parameter",
-			"foo + bar",
-            "bazquux",
-            {},
+			"Not-regex against right-hand parameter",
+			"'foobar' !~ foo",
+			true,
+			{},
 			{
 				{
 					"foo",
 					"baz",
 				},
-				{
-					"bar",
-					"quux",
-				},
 			},
-			
 		},
 		{
 
-			"String concat with float parameter",
-			"foo + bar",
-            "baz123",
+			"Regex against two parameters",
+			"foo =~ bar",
+			true,
+			{},
+			{
+				{
+					"foo",
+					"foobar",
+				},
+				{
+					"bar",
+					"oba",
+				},
+			},
+		},
+		{
+
+			"Not-regex against two parameters",
+			"foo !~ bar",
+			true,
+			{},
+			{
+				{
+					"foo",
+					"foobar",
+				},
+				{
+					"bar",
+					"baz",
+				},
+			},
+		},
+		{
+
+			"Literal regex",
+			"foo =~ '[fF][oO]+'",
+			true,
+			{},
+			{
+				{
+					"foo",
+					"foobar",
+				},
+			},
+		},
+		{
+
+			"Literal not-regex",
+			"foo !~ '[fF][oO]+'",
+			false,
+			{},
+			{
+				{
+					"foo",
+					"foobar",
+				},
+			},
+		},
+		{
+
+			"Literal regex in a logical expression",
+			"foo =~ '^ba' || foo =~ 'r$'",
+			true,
+			{},
+			{
+				{
+					"foo",
+					"foobar",
+				},
+			},
+		},
+		{
+
+			"Single boolean parameter",
+			"commission ? 10",
+			float(10),
+			{},
+			{
+				{
+					"commission",
+					true,
+				},
+			},
+		},
+		{
+
+			"True comparator with a parameter",
+			"partner == 'amazon' ? 10",
+			float(10),
+			{},
+			{
+				{
+					"partner",
+					"amazon",
+				},
+			},
+		},
+		{
+
+			"False comparator with a parameter",
+			"partner == 'amazon' ? 10",
+			nullptr,
+			{},
+			{
+				{
+					"partner",
+					"ebay",
+				},
+			},
+		},
+		{
+
+			"True comparator with multiple parameters",
+			"theft && period == 24 ? 60",
+			float(60),
+			{},
+			{
+				{
+					"theft",
+					true,
+				},
+				{
+					"period",
+					24,
+				},
+			},
+		},
+		{
+
+			"False comparator with multiple parameters",
+			"theft && period == 24 ? 60",
+			nullptr,
+			{},
+			{
+				{
+					"theft",
+					false,
+				},
+				{
+					"period",
+					24,
+				},
+			},
+		},
+		{
+
+			"String concat with single string parameter",
+			"foo + 'bar'",
+            "bazbar",
+            {},
+			{
+				{
+					"foo",
+					"baz",
+				},
+			},
+			
+		},
+		{
+
+			"String concat with multiple string parameter",
+			"foo + bar",
+            "bazquux",
+            {},
+			{
+				{
+					"foo",
+					"baz",
+				},
+				{
+					"bar",
+					"quux",
+				},
+			},
+			
+		},
+		{
+
+			"String concat with float parameter",
+			"foo + bar",
+            "baz123",
             {},
 			{
 				{
@@ -1140,18 +1198,19 @@ TEST(TestEvaluation, TestParameterizedEvaluation) {
 				},
 			},
 		},
-		// {
+		{
 
-		// 	"Null coalesce right",
-		// 	"foo ?? 1.0",
-		// 	{
-		// 		{
-		// 			"foo",
-		// 			nil,
-		// 		},
-		// 	},
-		// 	1.0,
-		// },
+			"Null coalesce right",
+			"foo ?? 1.0",
+			float(1),
+			{},
+			{
+				{
+					"foo",
+					nullptr,
+				},
+			},
+		},
 		{
 
 			"Multiple comparator/logical operators (#30)",
@@ -1261,50 +1320,62 @@ TEST(TestEvaluation, TestParameterizedEvaluation) {
 				},
 			},
 		},
-		// {
+		{
 
-		// 	"Short-circuit OR",
-		// 	"true || fail()",
-		// 	Functions: map[string]ExpressionFunction{
-		// 		"fail": func(arguments ...interface{}) (interface{}, error) {
-		// 			return nil, errors.New("Did not short-circuit")
-		// 		},
-		// 	},
-		// 	true,
-		// },
-		// {
+			"Short-circuit OR",
+			"true || fail()",
+			true,
+			{
+				{
+                    "fail",
+                    [] (Cvaluate::TokenAvaiableData) -> Cvaluate::TokenAvaiableData {
+                        throw Cvaluate::CvaluateException("Did not short-circuit");
+                    }
+				},
+			},
+		},
+		{
 
-		// 	"Short-circuit AND",
-		// 	"false && fail()",
-		// 	Functions: map[string]ExpressionFunction{
-		// 		"fail": func(arguments ...interface{}) (interface{}, error) {
-		// 			return nil, errors.New("Did not short-circuit")
-		// 		},
-		// 	},
-		// 	false,
-		// },
-		// {
+			"Short-circuit AND",
+			"false && fail()",
+			false,
+			{
+				{
+                    "fail",
+                    [] (Cvaluate::TokenAvaiableData) -> Cvaluate::TokenAvaiableData {
+                        throw Cvaluate::CvaluateException("Did not short-circuit");
+                    }
+				},
+			},
+		},
+		{
 
-		// 	"Short-circuit ternary",
-		// 	"true ? 1 : fail()",
-		// 	Functions: map[string]ExpressionFunction{
-		// 		"fail": func(arguments ...interface{}) (interface{}, error) {
-		// 			return nil, errors.New("Did not short-circuit")
-		// 		},
-		// 	},
-		// 	1.0,
-		// },
-		// {
+			"Short-circuit ternary",
+			"true ? 1 : fail()",
+			float(1),
+			{
+				{
+                    "fail",
+                    [] (Cvaluate::TokenAvaiableData) -> Cvaluate::TokenAvaiableData {
+                        throw Cvaluate::CvaluateException("Did not short-circuit");
+                    }
+				},
+			},
+		},
+		{
 
-		// 	"Short-circuit coalesce",
-		// 	"'foo' ?? fail()",
-		// 	Functions: map[string]ExpressionFunction{
-		// 		"fail": func(arguments ...interface{}) (interface{}, error) {
-		// 			return nil, errors.New("Did not short-circuit")
-		// 		},
-		// 	},
-		// 	"foo",
-		// },
+			"Short-circuit coalesce",
+			"'foo' ?? fail()",
+			"foo",
+			{
+				{
+                    "fail",
+                    [] (Cvaluate::TokenAvaiableData) -> Cvaluate::TokenAvaiableData {
+                        throw Cvaluate::CvaluateException("Did not short-circuit");
+                    }
+				},
+			},
+		},
 		{
 
 			"Simple parameter call",
@@ -1425,16 +1496,561 @@ TEST(TestEvaluation, TestParameterizedEvaluation) {
 			{},
             fooParameter
 		},
-		// {
+		{
 
-		// 	"Null coalesce nested parameter",
-		// 	"foo.Nil ?? false",
-		// 	{fooParameter},
-		// 	false,
-		// },
+			"Null coalesce nested parameter",
+			"foo.Nil ?? false",
+			false,
+			{},
+			fooParameter,
+		},
     };
 
     RunEvaluationTests(token_evaluation_tests);
 }
 
+TEST(TestEvaluation, TestConstantFolding) {
+    // EQ(PLUS(NOOP(2), NOOP(2)), NOOP(4)) folds into a single literal.
+    auto literal_expression = Cvaluate::EvaluableExpression("(2) + (2) == (4)");
+    ASSERT_EQ(literal_expression.Statistics().folded_stages, 7);
+    ASSERT_EQ(literal_expression.Evaluate(), true);
+
+    // PLUS(foo, NOOP(MULTIPLY(1, 2))) keeps the parameter stage.
+    auto parameter_expression = Cvaluate::EvaluableExpression("foo + (1 * 2)");
+    ASSERT_EQ(parameter_expression.Statistics().folded_stages, 3);
+    ASSERT_EQ(parameter_expression.Evaluate({{"foo", float(1)}}), float(3));
+
+    // A deciding left literal removes the right stage.
+    auto short_circuit_expression = Cvaluate::EvaluableExpression("false && foo > 1");
+    ASSERT_EQ(short_circuit_expression.Statistics().folded_stages, 4);
+    ASSERT_EQ(short_circuit_expression.Evaluate(), false);
+
+    // Literal subtrees that fail to evaluate aren't folded, their type errors are raised by the type inference.
+    ASSERT_THROW(Cvaluate::EvaluableExpression("1 - 'foo'"), Cvaluate::CvaluateException);
+}
+
+TEST(TestEvaluation, TestTypeInference) {
+    // Literal operand types are checked when planning.
+    std::vector<std::string> invalid_expressions = {
+        "foo - 'bar'",
+        "foo > 1 && 'bar'",
+        "!(foo - 1)",
+        "'bar' ? foo : 1",
+        "(foo > 1) > true",
+    };
+
+    for (auto& input: invalid_expressions) {
+        ASSERT_THROW(Cvaluate::EvaluableExpression{input}, Cvaluate::CvaluateException) << input;
+    }
+
+    // Without a schema, parameters may have any type.
+    auto untyped_expression = Cvaluate::EvaluableExpression("foo > bar");
+    ASSERT_EQ(untyped_expression.Statistics().specialized_stages, 0);
+    ASSERT_EQ(untyped_expression.Evaluate({{"foo", "b"}, {"bar", "a"}}), true);
+
+    // Declared types are checked and specialize the stages.
+    Cvaluate::ParameterSchema schema = {
+        {"foo", Cvaluate::StageType::NUMERIC},
+        {"bar.baz", Cvaluate::StageType::STRING},
+    };
+
+    ASSERT_THROW(Cvaluate::EvaluableExpression("foo + 1 > bar.baz", {}, schema), Cvaluate::CvaluateException);
+
+    auto typed_expression = Cvaluate::EvaluableExpression("foo + 1 > 2 && bar.baz == 'qux'", {}, schema);
+    ASSERT_EQ(typed_expression.Statistics().specialized_stages, 3);
+
+    for (auto mode: kEvaluationModes) {
+        typed_expression.SetEvaluationMode(mode);
+        ASSERT_EQ(typed_expression.Evaluate({{"foo", 2}, {"bar", {{"baz", "qux"}}}}), true);
+
+        // Parameters that don't match the schema take the generic path.
+        ASSERT_EQ(typed_expression.Evaluate({{"foo", 2}, {"bar", {{"baz", 1}}}}), false);
+    }
+}
+
+TEST(TestEvaluation, TestCommonSubexpressions) {
+    int pure_calls = 0, impure_calls = 0;
+    Cvaluate::ExpressionFunctionMap functions = {
+        {"pure", Cvaluate::MakePureFunction([&pure_calls](Cvaluate::TokenAvaiableData argument) {
+            pure_calls++;
+            return argument;
+        })},
+        {"impure", [&impure_calls](Cvaluate::TokenAvaiableData argument) {
+            impure_calls++;
+            return argument;
+        }},
+    };
+
+    struct CommonSubexpressionTest {
+        std::string input;
+        size_t eliminated_stages;
+        size_t shared_stages;
+        int pure_calls;
+        int impure_calls;
+        bool other_result;
+    };
+
+    std::vector<CommonSubexpressionTest> tests = {
+        // The second call and its argument are removed, the call is shared.
+        {"pure(foo) > 1 && pure(foo) < 5", 2, 1, 1, 0, false},
+        // Calls to functions that aren't pure are kept apart, only their argument is merged.
+        {"impure(foo) > 1 && impure(foo) < 5", 1, 0, 0, 2, false},
+        {"foo + bar > 2 || foo + bar < 0", 3, 1, 0, 0, true},
+        // A shared stage skipped by its first parent is computed by the next one.
+        {"flag && pure(foo) == 3 || pure(foo) == 3", 4, 1, 1, 0, false},
+    };
+
+    Cvaluate::Parameters parameters = {{"foo", 3}, {"bar", 1}, {"flag", false}};
+
+    for (auto& test: tests) {
+        auto expression = Cvaluate::EvaluableExpression(test.input, functions);
+        ASSERT_EQ(expression.Statistics().eliminated_stages, test.eliminated_stages) << test.input;
+        ASSERT_EQ(expression.Statistics().shared_stages, test.shared_stages) << test.input;
+
+        for (auto mode: kEvaluationModes) {
+            expression.SetEvaluationMode(mode);
+            pure_calls = impure_calls = 0;
+
+            ASSERT_EQ(expression.Evaluate(parameters), true) << test.input;
+            ASSERT_EQ(pure_calls, test.pure_calls) << test.input;
+            ASSERT_EQ(impure_calls, test.impure_calls) << test.input;
+
+            // Kept results don't leak into the next row of a batch.
+            std::vector<Cvaluate::Parameters> rows = {parameters, {{"foo", 10}, {"bar", 1}, {"flag", false}}};
+            auto results = expression.EvaluateBatch(rows);
+            ASSERT_EQ(results[0], true) << test.input;
+            ASSERT_EQ(results[1], test.other_result) << test.input;
+        }
+    }
+}
+
+TEST(TestEvaluation, TestVariadicFunctions) {
+    int pure_calls = 0;
+    auto describe = [](const Cvaluate::FunctionArguments& arguments) -> Cvaluate::TokenAvaiableData {
+        auto ret = Cvaluate::TokenAvaiableData::array();
+        for (size_t i = 0; i < arguments.size(); i++) {
+            ret.push_back(arguments[i]);
+        }
+        return ret;
+    };
+
+    Cvaluate::ExpressionFunctionMap functions = {
+        {"args", Cvaluate::MakeVariadicFunction(describe)},
+        {"count", Cvaluate::MakePureFunction(Cvaluate::MakeVariadicFunction([&pure_calls](const Cvaluate::FunctionArguments& arguments) {
+            pure_calls++;
+            return Cvaluate::TokenAvaiableData(arguments.size());
+        }))},
+        {"legacy", [](Cvaluate::TokenAvaiableData argument) {
+            return argument;
+        }},
+    };
+
+    struct VariadicFunctionTest {
+        std::string input;
+        Cvaluate::TokenAvaiableData expected;
+    };
+
+    std::vector<VariadicFunctionTest> tests = {
+        {"args()", Cvaluate::TokenAvaiableData::array()},
+        {"args(1)", {1.0}},
+        {"args(foo, bar.baz, 'x' + 'y')", {3, "long string argument", "xy"}},
+        // Arrays stay one argument, and literal arguments aren't folded together.
+        {"args(arr, 1, 2)", {{1, 2}, 1.0, 2.0}},
+        {"args(1, (2, 3))", {1.0, {2.0, 3.0}}},
+        {"args(args(foo), foo)", {{3}, 3}},
+        {"count(foo, foo) + count(foo, foo)", 4.0},
+        // Functions taking a single value still get the arguments packed the way they always did.
+        {"legacy()", nullptr},
+        {"legacy(foo)", 3},
+        {"legacy(foo, 1)", {3, 1.0}},
+        {"legacy(arr, 3)", {1, 2, 3.0}},
+        {"legacy((1, 2), 3)", {1.0, 2.0, 3.0}},
+    };
+
+    Cvaluate::Parameters parameters = {{"foo", 3}, {"bar", {{"baz", "long string argument"}}}, {"arr", {1, 2}}};
+
+    for (auto& test: tests) {
+        auto expression = Cvaluate::EvaluableExpression(test.input, functions);
+
+        for (auto mode: kEvaluationModes) {
+            expression.SetEvaluationMode(mode);
+            pure_calls = 0;
+
+            ASSERT_EQ(expression.Evaluate(parameters), test.expected) << test.input;
+            ASSERT_LE(pure_calls, 1) << test.input;
+
+            // The argument storage is reused from one row to the next.
+            std::vector<Cvaluate::Parameters> rows = {parameters, parameters};
+            auto results = expression.EvaluateBatch(rows);
+            ASSERT_EQ(results[0], test.expected) << test.input;
+            ASSERT_EQ(results[1], test.expected) << test.input;
+        }
+    }
+
+    // Called with a single value, a variadic function spreads arrays into its arguments.
+    auto& args = functions["args"];
+    ASSERT_EQ(args(Cvaluate::TokenAvaiableData({1, 2})), Cvaluate::TokenAvaiableData({1, 2}));
+    ASSERT_EQ(args("foo"), Cvaluate::TokenAvaiableData({"foo"}));
+    ASSERT_EQ(args(nullptr), Cvaluate::TokenAvaiableData::array());
+}
+
+TEST(TestEvaluation, TestParameterFrameEvaluation) {
+    auto expression = Cvaluate::EvaluableExpression("foo + bar.baz > foo * 2 && (qux || bar.quux)");
+
+    // Each distinct variable gets one slot, accessors share the slot of their root.
+    std::vector<std::string> slots = {"foo", "bar", "qux"};
+    ASSERT_EQ(expression.ParameterSlots(), slots);
+    ASSERT_EQ(expression.FindParameterSlot("bar"), 1);
+    ASSERT_EQ(expression.FindParameterSlot("missing"), -1);
+
+    Cvaluate::TokenAvaiableData foo = float(1);
+    Cvaluate::TokenAvaiableData bar = {{"baz", float(2)}, {"quux", false}};
+    Cvaluate::TokenAvaiableData qux = true;
+
+    auto frame = expression.MakeParameterFrame();
+    frame.Bind(expression.FindParameterSlot("foo"), foo);
+    frame.Bind(expression.FindParameterSlot("bar"), bar);
+    frame.Bind(expression.FindParameterSlot("qux"), qux);
+    ASSERT_EQ(expression.Evaluate(frame), true);
+
+    // Bound values are borrowed, so updates are seen by the next evaluation.
+    foo = float(3);
+    ASSERT_EQ(expression.Evaluate(frame), false);
+
+    // Unbound slots only fail when they are actually read.
+    frame.Unbind(expression.FindParameterSlot("qux"));
+    ASSERT_EQ(expression.Evaluate(frame), false);
+    foo = float(1);
+    ASSERT_THROW(expression.Evaluate(frame), Cvaluate::CvaluateException);
+
+    ASSERT_THROW(expression.Evaluate(Cvaluate::ParameterFrame(1)), Cvaluate::CvaluateException);
+}
+
+TEST(TestEvaluation, TestBatchEvaluation) {
+    auto expression = Cvaluate::EvaluableExpression("foo > bar.baz ? 'high' : foo");
+    auto bool_expression = Cvaluate::EvaluableExpression("foo > bar.baz");
+
+    std::vector<Cvaluate::Parameters> rows;
+    for (int i = 0; i < 16; i++) {
+        rows.push_back({{"foo", i}, {"bar", {{"baz", 8}}}});
+    }
+
+    for (auto mode: kEvaluationModes) {
+        expression.SetEvaluationMode(mode);
+        bool_expression.SetEvaluationMode(mode);
+
+        auto results = expression.EvaluateBatch(rows);
+        std::unique_ptr<bool[]> bool_results(new bool[rows.size()]);
+        bool_expression.EvaluateBatch(rows.data(), rows.size(), bool_results.get());
+
+        ASSERT_EQ(results.size(), rows.size());
+        for (size_t i = 0; i < rows.size(); i++) {
+            ASSERT_EQ(results[i], expression.Evaluate(rows[i]));
+            ASSERT_EQ(bool_results[i], i > 8);
+        }
+
+        // Slots bound by a previous row don't leak into the next one.
+        std::vector<Cvaluate::Parameters> missing_rows = {rows[0], {{"bar", {{"baz", 1}}}}};
+        ASSERT_THROW(expression.EvaluateBatch(missing_rows), Cvaluate::CvaluateException);
+
+        std::unique_ptr<bool[]> non_bool_results(new bool[rows.size()]);
+        ASSERT_THROW(expression.EvaluateBatch(rows.data(), rows.size(), non_bool_results.get()), Cvaluate::CvaluateException);
+    }
+}
+
+/*
+    Runs every task on the submitting thread, to test the chunking without depending on scheduling.
+*/
+class InlineExecutor : public Cvaluate::Executor {
+    public:
+        size_t submitted = 0;
+
+        void Submit(std::function<void()> task) override {
+            submitted++;
+            task();
+        }
+
+        size_t Concurrency() const override {
+            return 3;
+        }
+};
+
+TEST(TestEvaluation, TestParallelBatchEvaluation) {
+    auto expression = Cvaluate::EvaluableExpression("foo > bar.baz ? 'high' : foo");
+    auto bool_expression = Cvaluate::EvaluableExpression("foo > bar.baz");
+
+    std::vector<Cvaluate::Parameters> rows;
+    for (int i = 0; i < 5000; i++) {
+        rows.push_back({{"foo", i % 100}, {"bar", {{"baz", 50}}}});
+    }
+
+    Cvaluate::ThreadPool pool(4);
+    InlineExecutor inline_executor;
+
+    for (auto mode: kEvaluationModes) {
+        expression.SetEvaluationMode(mode);
+        bool_expression.SetEvaluationMode(mode);
+        auto expected = expression.EvaluateBatch(rows);
+
+        ASSERT_EQ(expression.EvaluateBatchParallel(rows, pool), expected);
+
+        for (size_t chunk_size: {1, 7, 1000, 10000}) {
+            std::vector<Cvaluate::TokenAvaiableData> results(rows.size());
+            expression.EvaluateBatchParallel(rows.data(), rows.size(), results.data(), pool, chunk_size);
+            ASSERT_EQ(results, expected);
+
+            std::unique_ptr<bool[]> bool_results(new bool[rows.size()]);
+            bool_expression.EvaluateBatchParallel(rows.data(), rows.size(), bool_results.get(), inline_executor, chunk_size);
+            for (size_t i = 0; i < rows.size(); i++) {
+                ASSERT_EQ(bool_results[i], i % 100 > 50);
+            }
+        }
+
+        auto failing_rows = rows;
+        failing_rows[4321] = {{"bar", {{"baz", 1}}}};
+        std::vector<Cvaluate::TokenAvaiableData> results(rows.size());
+        ASSERT_THROW(expression.EvaluateBatchParallel(failing_rows.data(), failing_rows.size(), results.data(), pool, 16),
+            Cvaluate::CvaluateException);
+    }
+
+    // At most one task per slot of the executor, the calling thread takes the rest.
+    inline_executor.submitted = 0;
+    std::unique_ptr<bool[]> bool_results(new bool[rows.size()]);
+    bool_expression.EvaluateBatchParallel(rows.data(), rows.size(), bool_results.get(), inline_executor, 100);
+    ASSERT_EQ(inline_executor.submitted, 3);
+
+    ASSERT_THROW(expression.EvaluateBatchParallel(rows.data(), rows.size(), bool_results.get(), pool, 0),
+        Cvaluate::CvaluateException);
+}
+
+TEST(TestEvaluation, TestQuantifiers) {
+    std::vector<std::string> expressions = {"foo == 700", "foo >= 0", "foo > 2000", "foo % 3 == 1"};
+
+    std::vector<Cvaluate::Parameters> rows;
+    for (int i = 0; i < 1000; i++) {
+        rows.push_back({{"foo", i}});
+    }
+
+    auto failing_rows = rows;
+    failing_rows[500] = {};
+
+    Cvaluate::ThreadPool pool(4);
+    InlineExecutor inline_executor;
+
+    for (auto& input: expressions) {
+        auto expression = Cvaluate::EvaluableExpression(input);
+        std::unique_ptr<bool[]> results(new bool[rows.size()]);
+        expression.EvaluateBatch(rows.data(), rows.size(), results.get());
+        auto first = std::find(results.get(), results.get() + rows.size(), true) - results.get();
+        auto count = std::count(results.get(), results.get() + rows.size(), true);
+
+        for (auto mode: kEvaluationModes) {
+            expression.SetEvaluationMode(mode);
+
+            ASSERT_EQ(expression.EvaluateAny(rows.data(), rows.size()), first < 1000) << input;
+            ASSERT_EQ(expression.EvaluateAll(rows.data(), rows.size()), count == 1000) << input;
+            ASSERT_EQ(expression.EvaluateFirst(rows.data(), rows.size()), first) << input;
+            ASSERT_EQ(expression.EvaluateCount(rows.data(), rows.size()), count) << input;
+
+            for (size_t chunk_size: {1, 7, 100, 10000}) {
+                ASSERT_EQ(expression.EvaluateAny(rows.data(), rows.size(), pool, chunk_size), first < 1000) << input;
+                ASSERT_EQ(expression.EvaluateAll(rows.data(), rows.size(), pool, chunk_size), count == 1000) << input;
+                ASSERT_EQ(expression.EvaluateFirst(rows.data(), rows.size(), pool, chunk_size), first) << input;
+                ASSERT_EQ(expression.EvaluateCount(rows.data(), rows.size(), inline_executor, chunk_size), count) << input;
+            }
+
+            // A failing row only throws when the rows before it don't decide the result.
+            if (first < 500) {
+                ASSERT_EQ(expression.EvaluateFirst(failing_rows.data(), failing_rows.size()), first) << input;
+                ASSERT_EQ(expression.EvaluateFirst(failing_rows.data(), failing_rows.size(), pool, 7), first) << input;
+            } else {
+                ASSERT_THROW(expression.EvaluateAny(failing_rows.data(), failing_rows.size()), Cvaluate::CvaluateException);
+                ASSERT_THROW(expression.EvaluateAny(failing_rows.data(), failing_rows.size(), pool, 7),
+                    Cvaluate::CvaluateException);
+            }
+            ASSERT_THROW(expression.EvaluateCount(failing_rows.data(), failing_rows.size(), pool, 7),
+                Cvaluate::CvaluateException);
+        }
+    }
+
+    // The rows after the deciding one aren't evaluated.
+    std::atomic<int> calls{0};
+    Cvaluate::ExpressionFunctionMap functions = {
+        {"check", [&calls](Cvaluate::TokenAvaiableData arguments) -> Cvaluate::TokenAvaiableData {
+            calls++;
+            return arguments.get<int>() == 3;
+        }},
+    };
+    auto expression = Cvaluate::EvaluableExpression("check(foo)", functions);
+
+    ASSERT_EQ(expression.EvaluateFirst(rows.data(), rows.size()), 3);
+    ASSERT_EQ(calls, 4);
+    ASSERT_FALSE(expression.EvaluateAll(rows.data(), rows.size()));
+    ASSERT_EQ(calls, 5);
+
+    // The inline executor runs the chunks in order, the ones after the deciding row are skipped.
+    calls = 0;
+    ASSERT_TRUE(expression.EvaluateAny(rows.data(), rows.size(), inline_executor, 10));
+    ASSERT_EQ(calls, 4);
+}
+
+TEST(TestEvaluation, TestThreadPool) {
+    std::atomic<int> count{0};
+
+    {
+        Cvaluate::ThreadPool pool(3);
+        ASSERT_EQ(pool.Concurrency(), 3);
+
+        // Tasks submitted by a task are queued on the worker running it.
+        for (int i = 0; i < 100; i++) {
+            pool.Submit([&pool, &count] {
+                count++;
+                pool.Submit([&count] { count++; });
+            });
+        }
+    }
+
+    ASSERT_EQ(count, 200);
+    ASSERT_EQ(Cvaluate::ThreadPool(0).Concurrency(), 1);
+}
+
+TEST(TestEvaluation, TestRegexPatterns) {
+    auto& regexes = Cvaluate::RegexCache::Default();
+    Cvaluate::Parameters parameters = {{"foo", "foobar"}, {"pattern", "^fo+"}};
+
+    // Literal patterns are compiled while parsing, evaluations don't look them up.
+    auto literal = Cvaluate::EvaluableExpression("foo =~ 'o{2}b'");
+    auto dynamic = Cvaluate::EvaluableExpression("foo =~ pattern");
+
+    for (auto mode: kEvaluationModes) {
+        literal.SetEvaluationMode(mode);
+        dynamic.SetEvaluationMode(mode);
+
+        auto before = regexes.Statistics();
+        ASSERT_EQ(literal.Evaluate(parameters), true);
+        ASSERT_EQ(regexes.Statistics().hits + regexes.Statistics().misses, before.hits + before.misses);
+
+        ASSERT_EQ(dynamic.Evaluate(parameters), true);
+        ASSERT_EQ(dynamic.Evaluate(parameters), true);
+        ASSERT_GE(regexes.Statistics().hits, before.hits + 1);
+    }
+
+    ASSERT_THROW(Cvaluate::EvaluableExpression{"foo =~ '(unclosed'"}, Cvaluate::CvaluateException);
+    ASSERT_THROW(Cvaluate::EvaluableExpression{"foo =~ '(un' + 'closed'"}, Cvaluate::CvaluateException);
+
+    // Only the whole pattern is compiled, its first string alone may not be a valid pattern.
+    for (auto mode: kEvaluationModes) {
+        Cvaluate::EvaluableExpression folded("foo =~ '(' + 'o+)'");
+        Cvaluate::EvaluableExpression concatenated("foo =~ '^(' + bar + ')$'");
+        folded.SetEvaluationMode(mode);
+        concatenated.SetEvaluationMode(mode);
+
+        ASSERT_EQ(folded.Evaluate({{"foo", "foobar"}}), true);
+        ASSERT_EQ(concatenated.Evaluate({{"foo", "foobar"}, {"bar", "fo+bar"}}), true);
+        ASSERT_EQ(concatenated.Evaluate({{"foo", "foobar"}, {"bar", "fo+"}}), false);
+    }
+    ASSERT_THROW(dynamic.Evaluate({{"foo", "foobar"}, {"pattern", "(unclosed"}}), Cvaluate::CvaluateException);
+
+    Cvaluate::RegexCache cache(2, 1);
+    auto first = cache.Get("a+");
+    ASSERT_EQ(cache.Get("a+"), first);
+    cache.Get("b+");
+    cache.Get("c+");
+    ASSERT_EQ(cache.Statistics().evictions, 1);
+    ASSERT_EQ(cache.Statistics().size, 2);
+    ASSERT_THROW(cache.Get("["), Cvaluate::CvaluateException);
+}
+
+TEST(TestEvaluation, TestMembership) {
+    std::string ids;
+    for (int i = 0; i < 200; i++) {
+        ids += (ids.empty() ? "'id" : ", 'id") + std::to_string(i) + "'";
+    }
+
+    // Short and long literal lists use different containers, an array parameter is scanned.
+    std::vector<std::pair<std::string, Cvaluate::Parameters>> cases = {
+        {"foo in (" + ids + ")", {{"foo", "id150"}}},
+        {"foo in ('id1', 'id150', 'id3')", {{"foo", "id150"}}},
+        {"foo in (1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 150)", {{"foo", 150}}},
+        {"foo in (1, 2, 150)", {{"foo", 150.0}}},
+        {"foo in (true, 'id150', 150)", {{"foo", true}}},
+        {"foo in bar", {{"foo", "id150"}, {"bar", {"id1", "id150"}}}},
+        {"foo.id in bar.ids", {{"foo", {{"id", 150}}}, {"bar", {{"ids", {1, 150}}}}}},
+        // 0.1 isn't exact as a float, literals are parsed as floats and `==` compares as floats.
+        {"foo in (0.1, 0.2)", {{"foo", 0.1}}},
+        {"foo in (0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.1)", {{"foo", 0.1}}},
+        {"foo in bar", {{"foo", 0.1}, {"bar", {0.2, static_cast<double>(0.1f)}}}},
+        {"foo in (0, 1)", {{"foo", -0.0}}},
+    };
+    std::vector<Cvaluate::Parameters> missing = {
+        {{"foo", "id200"}}, {{"foo", "id2"}}, {{"foo", 151}}, {{"foo", 151}},
+        {{"foo", false}}, {{"foo", "id2"}, {"bar", {"id1", "id150"}}}, {{"foo", {{"id", 2}}}, {"bar", {{"ids", {1, 150}}}}},
+        {{"foo", 0.3}}, {{"foo", 1.2}}, {{"foo", 0.3}, {"bar", {0.2, static_cast<double>(0.1f)}}}, {{"foo", 2}},
+    };
+
+    for (auto mode: kEvaluationModes) {
+        for (size_t i = 0; i < cases.size(); i++) {
+            auto expression = Cvaluate::EvaluableExpression(cases[i].first);
+            expression.SetEvaluationMode(mode);
+
+            ASSERT_EQ(expression.Evaluate(cases[i].second), true) << cases[i].first;
+            ASSERT_EQ(expression.Evaluate(missing[i]), false) << cases[i].first;
+        }
+    }
+
+    ASSERT_THROW(Cvaluate::EvaluableExpression("foo in bar").Evaluate({{"foo", 1}, {"bar", 1}}), Cvaluate::CvaluateException);
+
+    Cvaluate::MembershipSet set({1, "a", nullptr, {1, 2}});
+    ASSERT_EQ(set.Size(), 4);
+    ASSERT_TRUE(set.Contains(1.0));
+    ASSERT_TRUE(set.Contains(nullptr));
+    ASSERT_TRUE(set.Contains({1, 2}));
+    ASSERT_FALSE(set.Contains("b"));
+    ASSERT_TRUE(Cvaluate::MembershipSet({0.1f, 0.2f}).Contains(0.1));
+    ASSERT_FALSE(set.Contains(true));
+}
+
+TEST(TestEvaluation, TestValueConversions) {
+    std::vector<Cvaluate::TokenAvaiableData> values = {
+        nullptr, true, 42, 1.5, "short", "a string longer than the inline buffer",
+        {{"foo", 1}}, {1, 2, 3},
+    };
+
+    for (auto& value: values) {
+        ASSERT_EQ(Cvaluate::Value::Borrow(value).ToJson(), value);
+    }
+
+    // Only long strings, objects and arrays refer to the borrowed json.
+    ASSERT_EQ(Cvaluate::Value::Borrow(values[4]).GetType(), Cvaluate::Value::Type::SHORT_STRING);
+    ASSERT_EQ(Cvaluate::Value::Borrow(values[5]).GetStringView().data(), values[5].get_ref<const std::string&>().data());
+    ASSERT_EQ(Cvaluate::Value::Borrow(values[6]).GetType(), Cvaluate::Value::Type::JSON);
+
+    ASSERT_THROW(Cvaluate::Value::Borrow(values[4]).GetNumeric(), Cvaluate::CvaluateException);
+    ASSERT_THROW(Cvaluate::Value::Borrow(values[2]).GetBool(), Cvaluate::CvaluateException);
+
+    Cvaluate::ValueArena arena;
+    auto stored = arena.Store("a string owned by the arena");
+    ASSERT_EQ(stored.GetStringView(), "a string owned by the arena");
+}
+
+TEST(TestEvaluation, TestAccessorPaths) {
+    auto expression = Cvaluate::EvaluableExpression("foo.Nested.Missing");
+    const Cvaluate::Parameters parameters = {{"foo", {{"Nested", {{"Funk", "funkalicious"}}}, {"Int", 101}}}};
+    auto original = parameters;
+
+    for (auto mode: kEvaluationModes) {
+        expression.SetEvaluationMode(mode);
+
+        // Missing fields resolve to null without being inserted into the parameters.
+        ASSERT_TRUE(expression.Evaluate(parameters).is_null());
+        ASSERT_EQ(parameters, original);
+    }
+
+    auto scalar_expression = Cvaluate::EvaluableExpression("foo.Int.Value");
+    for (auto mode: kEvaluationModes) {
+        scalar_expression.SetEvaluationMode(mode);
+        ASSERT_THROW(scalar_expression.Evaluate(parameters), Cvaluate::CvaluateException);
+    }
+}
+
 } // namespace
\ No newline at end of file
@@ -0,0 +1,124 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <cvaluate/cvaluate.h>
+#include <cvaluate/Exception.h>
+
+namespace {
+
+TEST(TestExpressionCache, TestNormalizeExpression) {
+    std::vector<std::pair<std::string, std::string>> cases = {
+        {"  foo   >  1 ", "foo > 1"},
+        {"foo\t&&\n bar", "foo && bar"},
+        {"name == '  two  spaces '", "name == '  two  spaces '"},
+        {"name == \"a 'b'  c\"", "name == \"a 'b'  c\""},
+        {"name == 'it\\'s  ok'  ", "name == 'it\\'s  ok'"},
+        {"[escaped   name] > 1", "[escaped   name] > 1"},
+        {"[a\\]   b]  > 1", "[a\\]   b] > 1"},
+    };
+
+    for (auto& test_case: cases) {
+        ASSERT_EQ(Cvaluate::NormalizeExpression(test_case.first), test_case.second) << test_case.first;
+    }
+}
+
+TEST(TestExpressionCache, TestHitsAndEvictions) {
+    Cvaluate::ExpressionCache cache(2, 1);
+
+    auto first = cache.Get("foo > 1");
+    ASSERT_EQ(cache.Get("  foo  > 1"), first);
+    ASSERT_EQ(first->Evaluate({{"foo", 2}}), true);
+
+    cache.Get("foo > 2");
+    // "foo > 1" is the most recently used, so "foo > 2" is evicted.
+    cache.Get("foo > 1");
+    cache.Get("foo > 3");
+    ASSERT_EQ(cache.Get("foo > 1"), first);
+
+    auto statistics = cache.Statistics();
+    ASSERT_EQ(statistics.hits, 3);
+    ASSERT_EQ(statistics.misses, 3);
+    ASSERT_EQ(statistics.evictions, 1);
+    ASSERT_EQ(statistics.size, 2);
+
+    cache.Get("foo > 2");
+    ASSERT_EQ(cache.Statistics().misses, 4);
+
+    // Handed out expressions outlive their entries.
+    cache.Clear();
+    ASSERT_EQ(cache.Statistics().size, 0);
+    ASSERT_EQ(first->Evaluate({{"foo", 0}}), false);
+
+    ASSERT_THROW(cache.Get("1 - 'foo'"), Cvaluate::CvaluateException);
+    ASSERT_EQ(cache.Statistics().size, 0);
+    ASSERT_THROW(Cvaluate::ExpressionCache(0), Cvaluate::CvaluateException);
+
+    // An escaped bracket doesn't end the name, its spaces are part of the name.
+    auto escaped = cache.Get("[a\\]   b] == 1");
+    ASSERT_EQ(escaped->Evaluate({{"a]   b", 1}}), true);
+    ASSERT_EQ(escaped->Evaluate({{"a]   b", 2}, {"a] b", 1}}), false);
+}
+
+TEST(TestExpressionCache, TestFunctionSets) {
+    auto make_functions = [](float value) {
+        Cvaluate::ExpressionFunctionMap functions;
+        functions["get"] = [value](Cvaluate::TokenAvaiableData) -> Cvaluate::TokenAvaiableData {
+            return value;
+        };
+        return std::make_shared<const Cvaluate::ExpressionFunctionMap>(functions);
+    };
+    auto one = make_functions(1);
+    auto two = make_functions(2);
+
+    Cvaluate::ExpressionCache cache(16, 4, Cvaluate::EvaluationMode::CLOSURE);
+    auto with_one = cache.Get("get() + 1", one);
+    auto with_two = cache.Get("get() + 1", two);
+
+    ASSERT_NE(with_one, with_two);
+    ASSERT_EQ(cache.Get("get() + 1", one), with_one);
+    ASSERT_EQ(with_one->Evaluate(), 2.0);
+    ASSERT_EQ(with_two->Evaluate(), 3.0);
+    ASSERT_EQ(with_two->GetEvaluationMode(), Cvaluate::EvaluationMode::CLOSURE);
+}
+
+TEST(TestExpressionCache, TestConcurrentGets) {
+    Cvaluate::ExpressionCache cache(8, 4);
+    std::vector<std::thread> threads;
+    std::atomic<size_t> mismatches{0};
+
+    for (int thread = 0; thread < 8; thread++) {
+        threads.emplace_back([&cache, &mismatches, thread] {
+            for (int i = 0; i < 500; i++) {
+                auto bound = (thread + i) % 12;
+                auto expression = cache.Get("foo < " + std::to_string(bound));
+                if (expression->Evaluate({{"foo", 5}}) != (5 < bound)) {
+                    mismatches++;
+                }
+            }
+        });
+    }
+
+    for (auto& thread: threads) {
+        thread.join();
+    }
+
+    auto statistics = cache.Statistics();
+    ASSERT_EQ(mismatches, 0);
+    ASSERT_EQ(statistics.hits + statistics.misses, 4000);
+    ASSERT_LE(statistics.size, 8);
+}
+
+} // namespace
@@ -0,0 +1,91 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <cvaluate/cvaluate.h>
+#include <cvaluate/Exception.h>
+
+namespace {
+
+const Cvaluate::Parameters kRequest = {
+    {"r", {{"sub", "alice"}, {"obj", "/data/reports"}, {"act", "write"}}},
+    {"p", {{"sub", "alice"}, {"obj", "/data"}}},
+};
+
+TEST(TestExpressionSet, TestMatchesSeparateExpressions) {
+    std::vector<std::string> expressions = {
+        "r.sub == p.sub && r.act == 'read'",
+        "r.sub == p.sub && r.act == 'write'",
+        "r.sub == p.sub",
+        "r.act == 'write' ? 'allow' : 'deny'",
+        "r.obj + '/' + r.act",
+    };
+
+    Cvaluate::ExpressionSet set(expressions);
+    ASSERT_EQ(set.Size(), expressions.size());
+
+    auto results = set.Evaluate(kRequest);
+    ASSERT_EQ(results.size(), expressions.size());
+
+    for (size_t i = 0; i < expressions.size(); i++) {
+        ASSERT_EQ(set.Expression(i), expressions[i]);
+        ASSERT_EQ(results[i], Cvaluate::EvaluableExpression(expressions[i]).Evaluate(kRequest)) << expressions[i];
+    }
+
+    // r.sub, p.sub and their comparison in the second and third expressions,
+    // the comparison of r.act with 'write' in the fourth and r.act in every expression after the first.
+    ASSERT_EQ(set.EliminatedStages(), 4 + 3 + 3 + 1);
+}
+
+TEST(TestExpressionSet, TestSharedCalls) {
+    int calls = 0;
+    Cvaluate::ExpressionFunctionMap functions = {
+        {"keyMatch", Cvaluate::MakePureFunction([&calls](Cvaluate::TokenAvaiableData arguments) {
+            calls++;
+            auto key = arguments[0].get<std::string>();
+            auto pattern = arguments[1].get<std::string>();
+            return key.compare(0, pattern.size(), pattern) == 0;
+        })},
+    };
+
+    Cvaluate::ExpressionSet set({
+        "keyMatch(r.obj, p.obj) && r.act == 'read'",
+        "keyMatch(r.obj, p.obj) && r.act == 'write'",
+        "!keyMatch(r.obj, p.obj)",
+    }, functions);
+
+    auto results = set.Evaluate(kRequest);
+    ASSERT_EQ(results, std::vector<Cvaluate::TokenAvaiableData>({false, true, false}));
+    ASSERT_EQ(calls, 1);
+
+    // The kept results belong to one evaluation.
+    set.Evaluate(kRequest);
+    ASSERT_EQ(calls, 2);
+}
+
+TEST(TestExpressionSet, TestSubsets) {
+    Cvaluate::ExpressionSet set({"foo + 1", "foo + 2", "foo + 1 > 3"});
+
+    Cvaluate::Parameters parameters = {{"foo", 3}};
+    ASSERT_EQ(set.Evaluate(parameters, {2, 0}), std::vector<Cvaluate::TokenAvaiableData>({true, 4.0}));
+    ASSERT_EQ(set.Evaluate(parameters, {}), std::vector<Cvaluate::TokenAvaiableData>());
+    ASSERT_THROW(set.Evaluate(parameters, {3}), Cvaluate::CvaluateException);
+
+    // Errors of an expression are raised for the whole set.
+    ASSERT_THROW(set.Evaluate({}), Cvaluate::CvaluateException);
+    ASSERT_THROW(Cvaluate::ExpressionSet({"foo", ""}), Cvaluate::CvaluateException);
+}
+
+} // namespace
@@ -0,0 +1,145 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <cvaluate/cvaluate.h>
+#include <cvaluate/Exception.h>
+
+namespace {
+
+Cvaluate::TokenAvaiableData EvaluateOrNull(const std::string& expression, const Cvaluate::Parameters& facts) {
+    try {
+        return Cvaluate::EvaluableExpression(expression).Evaluate(facts);
+    } catch (const Cvaluate::CvaluateException&) {
+        return nullptr;
+    }
+}
+
+TEST(TestMatchNetwork, TestMatchesFreshEvaluation) {
+    std::vector<std::string> expressions = {
+        "r.sub == p.sub && r.act == 'read'",
+        "r.sub == p.sub || r.env.hour >= 18",
+        "r.env.hour >= 9 && r.env.hour < 18 ? 'office' : 'closed'",
+        "r.act in ('read', 'write') && !suspended",
+        "r.env",
+        "true",
+    };
+
+    struct TestCase {
+        std::string path;
+        Cvaluate::TokenAvaiableData value;
+    };
+
+    std::vector<TestCase> test_cases = {
+        {"r.act", "write"},
+        {"r.env.hour", 20},
+        {"p.sub", "alice"},
+        {"r.env", {{"hour", 10}}},
+        {"suspended", true},
+        {"r", {{"sub", "alice"}, {"act", "read"}}},
+        {"r.env.hour", 12},
+        {"suspended", false},
+        {"p", nullptr},
+    };
+
+    Cvaluate::Parameters facts = {
+        {"r", {{"sub", "alice"}, {"act", "read"}, {"env", {{"hour", 11}}}}},
+        {"p", {{"sub", "bob"}}},
+    };
+    Cvaluate::MatchNetwork network(expressions, facts);
+    ASSERT_EQ(network.Size(), expressions.size());
+
+    for (auto& test_case: test_cases) {
+        auto previous = network.Results();
+        auto changes = network.Update(test_case.path, test_case.value);
+
+        std::vector<bool> changed(expressions.size(), false);
+        for (auto& change: changes) {
+            ASSERT_EQ(change.previous, previous[change.expression]);
+            ASSERT_NE(change.previous, change.current);
+            changed[change.expression] = true;
+        }
+
+        for (size_t i = 0; i < expressions.size(); i++) {
+            auto expected = EvaluateOrNull(expressions[i], network.Facts());
+            ASSERT_EQ(network.Results()[i], expected) << expressions[i] << " after " << test_case.path;
+            ASSERT_EQ(changed[i], previous[i] != expected) << expressions[i] << " after " << test_case.path;
+        }
+    }
+}
+
+TEST(TestMatchNetwork, TestOnlyAffectedStages) {
+    int calls = 0;
+    Cvaluate::ExpressionFunctionMap functions = {
+        {"keyMatch", Cvaluate::MakePureFunction([&calls](Cvaluate::TokenAvaiableData arguments) {
+            calls++;
+            auto key = arguments[0].get<std::string>();
+            auto pattern = arguments[1].get<std::string>();
+            return key.compare(0, pattern.size(), pattern) == 0;
+        })},
+    };
+
+    Cvaluate::MatchNetwork network({
+        "keyMatch(r.obj, p.obj) && r.act == 'read'",
+        "keyMatch(r.obj, p.obj) && r.act == 'write'",
+    }, {
+        {"r", {{"obj", "/data/reports"}, {"act", "read"}}},
+        {"p", {{"obj", "/data"}}},
+    }, functions);
+    ASSERT_EQ(network.Results(), std::vector<Cvaluate::TokenAvaiableData>({true, false}));
+    ASSERT_EQ(calls, 1);
+
+    auto changes = network.Update("r.act", "write");
+    ASSERT_EQ(calls, 1);
+    ASSERT_EQ(changes.size(), 2);
+    ASSERT_EQ(changes[0].expression, 0);
+    ASSERT_EQ(changes[0].current, false);
+    ASSERT_EQ(changes[1].expression, 1);
+    ASSERT_EQ(changes[1].current, true);
+
+    // Fields no expression reads change nothing.
+    ASSERT_TRUE(network.Update("r.env.ip", "10.0.0.1").empty());
+    ASSERT_TRUE(network.Update("q", 1).empty());
+    ASSERT_EQ(calls, 1);
+
+    changes = network.Update("r.obj", "/home");
+    ASSERT_EQ(calls, 2);
+    ASSERT_EQ(changes.size(), 1);
+    ASSERT_EQ(changes[0].expression, 1);
+}
+
+TEST(TestMatchNetwork, TestMissingFacts) {
+    Cvaluate::MatchNetwork network({"user.age >= 18 && country == 'NL'"});
+    ASSERT_EQ(network.Results()[0], nullptr);
+
+    ASSERT_TRUE(network.Update("user.age", 30).empty());
+    ASSERT_EQ(network.Facts().at("user"), Cvaluate::TokenAvaiableData({{"age", 30}}));
+
+    auto changes = network.Update("country", "NL");
+    ASSERT_EQ(changes.size(), 1);
+    ASSERT_EQ(changes[0].previous, nullptr);
+    ASSERT_EQ(changes[0].current, true);
+
+    changes = network.Retract("country");
+    ASSERT_EQ(changes.size(), 1);
+    ASSERT_EQ(changes[0].current, nullptr);
+    ASSERT_TRUE(network.Retract("user.name").empty());
+    ASSERT_TRUE(network.Retract("user.age.years").empty());
+
+    ASSERT_THROW(network.Update("user.age.years", 1), Cvaluate::CvaluateException);
+    ASSERT_THROW(Cvaluate::MatchNetwork({"foo", ""}), Cvaluate::CvaluateException);
+}
+
+} // namespace
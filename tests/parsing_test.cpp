@@ -753,46 +753,44 @@ TEST(TestParse, TestComparatorParsing) {
 				},
 			},
 		},
-		// {
-
-		// 	"String REQ",
-		// 	"'foobar' =~ 'bar'",
-		// 	{
-		// 		{
-		// 			Cvaluate::TokenKind::STRING,
-		// 			std::string("foobar"),
-		// 		},
-		// 		{
-		// 			Cvaluate::TokenKind::COMPARATOR,
-		// 			std::string("=~"),
-		// 		},
+		{
 
-		// 		// it's not particularly clean to test for the contents of a pattern, (since it means modifying the harness below)
-		// 		// so pattern contents are left untested.
-		// 		ExpressionToken{
-		// 			Cvaluate::TokenKind::PATTERN,
-        //             std::string("");
-		// 		},
-		// 	},
-		// },
-		// TokenParsingTest{
+			"String REQ",
+			"'foobar' =~ 'bar'",
+			{
+				{
+					Cvaluate::TokenKind::STRING,
+					std::string("foobar"),
+				},
+				{
+					Cvaluate::TokenKind::COMPARATOR,
+					std::string("=~"),
+				},
+				{
+					Cvaluate::TokenKind::PATTERN,
+					std::string("bar"),
+				},
+			},
+		},
+		{
 
-		// 	Name:  "String NREQ",
-		// 	Input: "'foobar' !~ 'bar'",
-		// 	Expected: []ExpressionToken{
-		// 		ExpressionToken{
-		// 			Cvaluate::TokenKind::STRING,
-		// 			Value: "foobar",
-		// 		},
-		// 		ExpressionToken{
-		// 			Cvaluate::TokenKind::COMPARATOR,
-		// 			Value: "!~",
-		// 		},
-		// 		ExpressionToken{
-		// 			Kind: PATTERN,
-		// 		},
-		// 	},
-		// },
+			"String NREQ",
+			"'foobar' !~ 'bar'",
+			{
+				{
+					Cvaluate::TokenKind::STRING,
+					std::string("foobar"),
+				},
+				{
+					Cvaluate::TokenKind::COMPARATOR,
+					std::string("!~"),
+				},
+				{
+					Cvaluate::TokenKind::PATTERN,
+					std::string("bar"),
+				},
+			},
+		},
 		{
 
 			"Comparator against modifier string additive (#22)",
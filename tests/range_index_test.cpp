@@ -0,0 +1,98 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <cvaluate/cvaluate.h>
+#include <cvaluate/Exception.h>
+
+namespace {
+
+std::vector<size_t> MatchLinearly(const std::vector<std::shared_ptr<const Cvaluate::EvaluableExpression>>& rules,
+        const Cvaluate::Parameters& parameters) {
+    std::vector<size_t> matches;
+
+    for (size_t rule = 0; rule < rules.size(); rule++) {
+        if (rules[rule]->Evaluate(parameters) == true) {
+            matches.push_back(rule);
+        }
+    }
+
+    return matches;
+}
+
+TEST(TestRangeIndex, TestMatchesLinearScan) {
+    std::vector<std::string> inputs = {
+        "r.amount > 1000",
+        "r.amount <= 50 && r.risk < 0.3",
+        "r.amount >= 50 && r.amount < 100",
+        "100 <= r.amount && r.amount <= 100",
+        "r.risk > 0.5 && r.amount > 10",
+        // Contradicting bounds never match.
+        "r.amount > 10 && r.amount < 5",
+        "r.amount > 10 && r.amount < 10",
+        // Without a bound, or with bounds outside of the top-level conjunction, the rule is always a candidate.
+        "r.country == 'NL'",
+        "r.amount > 5000 || r.risk > 0.9",
+        // Only comparisons with a literal are bounds, this rule is indexed by `limit`.
+        "limit < 20 && r.amount >= limit",
+    };
+
+    // Thresholds differing only in their constant.
+    for (int threshold = 0; threshold < 400; threshold += 4) {
+        inputs.push_back("r.amount > " + std::to_string(threshold) + " && r.amount <= " + std::to_string(threshold + 10));
+    }
+
+    std::vector<std::shared_ptr<const Cvaluate::EvaluableExpression>> rules;
+    for (auto& input: inputs) {
+        rules.push_back(std::make_shared<Cvaluate::EvaluableExpression>(input));
+    }
+
+    Cvaluate::RangeIndex index(rules);
+    ASSERT_EQ(index.Size(), rules.size());
+    ASSERT_EQ(index.IndexedRules(), rules.size() - 2);
+
+    std::vector<double> amounts = {-1, 0, 4, 5, 10, 10.5, 49.9, 50, 99.99, 100, 100.5, 200, 390, 1000, 1000.01, 6000};
+
+    for (auto amount: amounts) {
+        for (auto risk: {0.1, 0.3, 0.95}) {
+            Cvaluate::Parameters parameters = {
+                {"r", {{"amount", amount}, {"risk", risk}, {"country", "NL"}}},
+                {"limit", 15},
+            };
+
+            ASSERT_EQ(index.Match(parameters), MatchLinearly(rules, parameters)) << amount << " " << risk;
+            ASSERT_LT(index.Candidates(parameters).size(), 20) << amount << " " << risk;
+        }
+    }
+}
+
+TEST(TestRangeIndex, TestVariablesThatArentNumbers) {
+    std::vector<std::shared_ptr<const Cvaluate::EvaluableExpression>> rules = {
+        std::make_shared<Cvaluate::EvaluableExpression>("amount > 10"),
+        std::make_shared<Cvaluate::EvaluableExpression>("amount <= 10"),
+        std::make_shared<Cvaluate::EvaluableExpression>("name > 'm'"),
+    };
+
+    Cvaluate::RangeIndex index(rules);
+    ASSERT_EQ(index.IndexedRules(), 2);
+    ASSERT_EQ(index.Match({{"amount", 11}, {"name", "z"}}), std::vector<size_t>({0, 2}));
+
+    // Every rule of a variable that isn't a number is a candidate, so the evaluation raises the same errors.
+    ASSERT_EQ(index.Candidates({{"amount", "11"}, {"name", "z"}}), std::vector<size_t>({0, 1, 2}));
+    ASSERT_THROW(index.Match({{"amount", "11"}, {"name", "z"}}), Cvaluate::CvaluateException);
+    ASSERT_THROW(index.Match({{"name", "z"}}), Cvaluate::CvaluateException);
+}
+
+} // namespace
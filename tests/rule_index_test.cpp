@@ -0,0 +1,126 @@
+/*
+* Copyright 2021 The casbin Authors. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <cvaluate/cvaluate.h>
+#include <cvaluate/Exception.h>
+
+namespace {
+
+std::vector<Cvaluate::TokenAvaiableData> MakePolicyRows(size_t count) {
+    std::vector<Cvaluate::TokenAvaiableData> rows;
+    const char* actions[] = {"read", "write", "delete"};
+
+    for (size_t i = 0; i < count; i++) {
+        rows.push_back({
+            {"sub", "user" + std::to_string(i % 50)},
+            {"obj", "data" + std::to_string(i % 7)},
+            {"act", actions[i % 3]},
+        });
+    }
+
+    return rows;
+}
+
+// Rows the expression is true for, evaluating every row.
+std::vector<size_t> MatchLinearly(const Cvaluate::EvaluableExpression& expression,
+        const std::vector<Cvaluate::TokenAvaiableData>& rows, Cvaluate::Parameters parameters) {
+    std::vector<size_t> matches;
+
+    for (size_t row = 0; row < rows.size(); row++) {
+        parameters["p"] = rows[row];
+        if (expression.Evaluate(parameters) == true) {
+            matches.push_back(row);
+        }
+    }
+
+    return matches;
+}
+
+TEST(TestRuleIndex, TestMatchesLinearScan) {
+    auto rows = MakePolicyRows(1050);
+    Cvaluate::ExpressionFunctionMap functions = {
+        {"keyMatch", Cvaluate::MakePureFunction([](Cvaluate::TokenAvaiableData arguments) {
+            auto key = arguments[0].get<std::string>();
+            auto pattern = arguments[1].get<std::string>();
+            return key.compare(0, pattern.size(), pattern) == 0;
+        })},
+    };
+
+    struct RuleIndexTest {
+        std::string input;
+        size_t indexed_predicates;
+    };
+
+    std::vector<RuleIndexTest> tests = {
+        {"r.sub == p.sub && r.obj == p.obj && r.act == p.act", 3},
+        {"p.sub == r.sub && keyMatch(r.obj, p.obj)", 1},
+        // Keys may be literals or computed from the request.
+        {"p.act == 'read' && p.obj == (keyMatch(r.obj, 'data') ? r.obj : '')", 2},
+        // Only the top-level conjunction narrows the rows down.
+        {"r.sub == p.sub || p.act == 'delete'", 0},
+        {"(r.sub == p.sub || r.sub == 'root') && r.act == p.act", 1},
+    };
+
+    std::vector<Cvaluate::Parameters> requests = {
+        {{"r", {{"sub", "user7"}, {"obj", "data0"}, {"act", "read"}}}},
+        {{"r", {{"sub", "root"}, {"obj", "data3"}, {"act", "write"}}}},
+        {{"r", {{"sub", "nobody"}, {"obj", "data9"}, {"act", "read"}}}},
+    };
+
+    for (auto& test: tests) {
+        auto expression = std::make_shared<Cvaluate::EvaluableExpression>(test.input, functions);
+        Cvaluate::RuleIndex index(expression, "p", rows);
+
+        ASSERT_EQ(index.Size(), rows.size());
+        ASSERT_EQ(index.IndexedPredicates(), test.indexed_predicates) << test.input;
+
+        for (auto& request: requests) {
+            ASSERT_EQ(index.Match(request), MatchLinearly(*expression, rows, request)) << test.input;
+
+            if (test.indexed_predicates > 0) {
+                ASSERT_LT(index.Candidates(request).size(), rows.size() / 2) << test.input;
+            }
+        }
+    }
+}
+
+TEST(TestRuleIndex, TestKeys) {
+    std::vector<Cvaluate::TokenAvaiableData> rows = {
+        {{"level", 1}},
+        {{"level", 1.0}},
+        {{"level", "1"}},
+        {{"level", nullptr}},
+        {},
+        {{"level", {1}}},
+        {{"level", true}},
+    };
+
+    auto expression = std::make_shared<Cvaluate::EvaluableExpression>("p.level == level");
+    Cvaluate::RuleIndex index(expression, "p", rows);
+
+    // Numbers compare by value, missing fields are null and arrays are candidates of every key.
+    ASSERT_EQ(index.Candidates({{"level", 1}}), std::vector<size_t>({0, 1, 5}));
+    ASSERT_EQ(index.Candidates({{"level", nullptr}}), std::vector<size_t>({3, 4, 5}));
+    ASSERT_EQ(index.Candidates({{"level", "1"}}), std::vector<size_t>({2, 5}));
+    ASSERT_EQ(index.Match({{"level", 1.0}}), std::vector<size_t>({0, 1}));
+    ASSERT_EQ(index.Match({{"level", true}}), std::vector<size_t>({6}));
+
+    // Without its key, the predicate doesn't narrow the rows down and the evaluation raises the error.
+    ASSERT_EQ(index.Candidates({}).size(), rows.size());
+    ASSERT_THROW(index.Match({}), Cvaluate::CvaluateException);
+}
+
+} // namespace